@@ -57,9 +57,17 @@ static double ssd_crossover_cost
  */
 void ssd_update_block_lifetime(double time, int blk, ssd_element_metadata *metadata)
 {
+    long long erasures = SSD_MAX_ERASURES - metadata->block_usage[blk].rem_lifetime;
+
     metadata->block_usage[blk].rem_lifetime --;
     metadata->block_usage[blk].time_of_last_erasure = time;
 
+    // update the running wear statistics. the square of the
+    // block's erasure count grows from e^2 to (e+1)^2.
+    metadata->plane_meta[metadata->block_usage[blk].plane_num].tot_erasures ++;
+    metadata->tot_erasures ++;
+    metadata->tot_erasures_sqr += 2 * erasures + 1;
+
     if (metadata->block_usage[blk].rem_lifetime < 0) {
         fprintf(stderr, "Error: Negative lifetime %d (block is being erased after it's dead)\n",
             metadata->block_usage[blk].rem_lifetime);
@@ -135,22 +143,14 @@ int ssd_rate_limit(int block_life, double avg_lifetime)
 
 /*
  * computes the average lifetime of all the blocks in a plane.
+ * the average remaining life time is the max num of erasures less
+ * the average num of erasures performed on the blocks so far.
  */
 double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
 {
-    int i;
-    int bitpos;
-    double tot_lifetime = 0;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    bitpos = plane_num * s->params.blocks_per_plane;
-    for (i = bitpos; i < bitpos + (int)s->params.blocks_per_plane; i ++) {
-        int block = ssd_bitpos_to_block(i, s);
-        ASSERT(metadata->block_usage[block].plane_num == plane_num);
-        tot_lifetime += metadata->block_usage[block].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_plane);
+    return (SSD_MAX_ERASURES - ((double)metadata->plane_meta[plane_num].tot_erasures / s->params.blocks_per_plane));
 }
 
 
@@ -159,15 +159,9 @@ double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
  */
 double ssd_compute_avg_lifetime_in_element(int elem_num, ssd_t *s)
 {
-    double tot_lifetime = 0;
-    int i;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        tot_lifetime += metadata->block_usage[i].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_element);
+    return (SSD_MAX_ERASURES - ((double)metadata->tot_erasures / s->params.blocks_per_element));
 }
 
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s)
@@ -248,32 +242,6 @@ int ssd_pick_wear_aware(int blk, int block_life, double avg_lifetime, ssd_t *s)
 }
 #endif
 
-static int _ssd_pick_block_to_clean
-(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
-{
-    int block_life;
-
-    if (plane_num != -1) {
-        if (metadata->block_usage[blk].plane_num != plane_num) {
-            return 0;
-        }
-    }
-
-    block_life = metadata->block_usage[blk].rem_lifetime;
-
-    // if the block is already dead, skip it
-    if (block_life == 0) {
-        return 0;
-    }
-
-    // clean only those blocks that are sealed.
-    /*if (!ssd_can_clean_block(s, metadata, blk)) {
-        return 0;
-    }*/
-
-    return 1;
-}
-
 /*
  * migrate data from a cold block to "to_blk"
  */
@@ -432,139 +400,97 @@ int ssd_pick_wear_aware_with_migration
 }
 
 /*
- * a greedy solution, where we find the block in a plane with the least
- * num of valid pages and return it.
+ * log usage table: every log block in use is linked on the list matching
+ * the num of valid pages in its data block and itself (the pages a full
+ * merge has to copy). the lists are updated whenever a page is written
+ * to the data or the log block, and when the log block is merged.
  */
-static int ssd_pick_block_to_clean2(int plane_num, int elem_num, double *mcost, ssd_element_metadata *metadata, ssd_t *s)
+static void ssd_log_usage_unlink(int log_index, ssd_element_metadata *metadata)
 {
-    double avg_lifetime = 1;
-    int i;
-    int size;
-    int block = -1;
-    int min_valid = s->params.pages_per_block - 1; // one page goes for the summary info
-    listnode *greedy_list;
-
-    *mcost = 0;
-
-    // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    // we create a list of greedily selected blocks
-    ll_create(&greedy_list);
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-
-            // greedily select the block
-            if (metadata->block_usage[i].num_valid <= min_valid) {
-                ASSERT(i == metadata->block_usage[i].block_num);
-                ll_insert_at_head(greedy_list, (void*)&metadata->block_usage[i]);
-                min_valid = metadata->block_usage[i].num_valid;
-                block = i;
-            }
-        }
-    }
+	log_table *log = &metadata->log_data[log_index];
 
-    ASSERT(block != -1);
-    block = -1;
+	if (log->usage_prev != -1) {
+		metadata->log_data[log->usage_prev].usage_next = log->usage_next;
+	} else {
+		ASSERT(metadata->log_usage[log->usage] == log_index);
+		metadata->log_usage[log->usage] = log->usage_next;
+	}
 
-    // from the greedily picked blocks, select one after rate
-    // limiting the overly used blocks
-    size = ll_get_size(greedy_list);
+	if (log->usage_next != -1) {
+		metadata->log_data[log->usage_next].usage_prev = log->usage_prev;
+	}
 
-    //printf("plane %d elem %d size %d avg lifetime %f\n",
-    //  plane_num, elem_num, size, avg_lifetime);
+	log->usage = -1;
+	log->usage_prev = -1;
+	log->usage_next = -1;
+}
 
-    for (i = 0; i < size; i ++) {
-        block_metadata *bm;
-        int mig_blk;
+/*
+ * removes a log block from the log usage table (when it is merged).
+ */
+void ssd_log_usage_remove(int log_index, ssd_element_metadata *metadata)
+{
+	if (metadata->log_data[log_index].usage != -1) {
+		ssd_log_usage_unlink(log_index, metadata);
+	}
+}
 
-        listnode *n = ll_get_nth_node(greedy_list, i);
-        bm = ((block_metadata *)n->data);
+/*
+ * moves a log block to the list matching its current usage.
+ */
+void ssd_log_usage_update(int log_index, ssd_element_metadata *metadata, ssd_t *s)
+{
+	log_table *log = &metadata->log_data[log_index];
+	int usage;
 
-        if (i == 0) {
-            ASSERT(min_valid == bm->num_valid);
-        }
+	if (log->bsn == -1) {
+		ssd_log_usage_remove(log_index, metadata);
+		return;
+	}
 
-        // this is the last of the greedily picked blocks.
-        if (i == size -1) {
-            // select it!
-            block = bm->block_num;
-            break;
-        }
+	ASSERT(log->lbn != -1);
+	usage = metadata->block_usage[metadata->lba_table[log->lbn]].num_valid + metadata->block_usage[log->bsn].num_valid;
+	ASSERT(usage <= 2 * s->params.pages_per_block);
 
-        if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
-            block = bm->block_num;
-            break;
-        } else {
-#if MIGRATE
-            // migration
-            mig_blk = ssd_pick_wear_aware_with_migration(bm->block_num, bm->rem_lifetime, avg_lifetime, mcost, bm->plane_num, elem_num, s);
-            if (mig_blk != bm->block_num) {
-                // data has been migrated and we have a new
-                // block to use
-                block = mig_blk;
-                break;
-            }
-#endif
+	if (log->usage == usage) {
+		return;
+	}
 
-            // pick this block giving consideration to its life time
-            if (ssd_pick_wear_aware(bm->block_num, bm->rem_lifetime, avg_lifetime, s)) {
-                block = bm->block_num;
-                break;
-            }
-        }
-    }
+	ssd_log_usage_remove(log_index, metadata);
 
-    ll_release(greedy_list);
+	log->usage = usage;
+	log->usage_prev = -1;
+	log->usage_next = metadata->log_usage[usage];
+	if (log->usage_next != -1) {
+		metadata->log_data[log->usage_next].usage_prev = log_index;
+	}
+	metadata->log_usage[usage] = log_index;
 
-    ASSERT(block != -1);
-    return block;
+	if (usage < metadata->log_usage_min) {
+		metadata->log_usage_min = usage;
+	}
 }
 
+/*
+ * picks the logical block whose data and log blocks together have the
+ * least num of valid pages.
+ */
 static int ssd_pick_block_to_clean(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
-	int block;
-	int log_block;
-	int lbn;
-	int min_valid = s->params.pages_per_block * 2;
-	int i,j;
-	double avg_lifetime = 1;
-	unsigned int reserved_blocks_per_plane = (s->params.reserve_blocks * s->params.blocks_per_plane) / 100;
-    unsigned int usable_blocks_per_plane = s->params.blocks_per_plane - reserved_blocks_per_plane;
-    unsigned int reserved_blocks = reserved_blocks_per_plane * s->params.planes_per_pkg;
-    unsigned int usable_blocks = usable_blocks_per_plane * s->params.planes_per_pkg;
-	int num_valid;
-
-	avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
+	int max_usage = s->params.pages_per_block * 2;
 
-	for(i = 0; i < usable_blocks ; i++) {
-		block = metadata->lba_table[i];
-		if(block == -1){
-			continue;
-		}
-		if( metadata->block_usage[block].log_index == -1){
-			continue;
-		}
+	// skip over the lists that have been emptied since
+	while ((metadata->log_usage_min <= max_usage) && (metadata->log_usage[metadata->log_usage_min] == -1)) {
+		metadata->log_usage_min++;
+	}
 
-		log_block = metadata->log_data[metadata->block_usage[block].log_index].bsn;
-		num_valid = metadata->block_usage[block].num_valid + metadata->block_usage[log_block].num_valid;
-		if(num_valid < min_valid) {
-			/*min_valid = metadata->block_usage[block].num_valid;
-			if(_ssd_pick_block_to_clean(block, plane_num, elem_num, metadata, s)){
-				int mig_blk;
-				block_metadata bm;
-				bm = metadata->block_usage[block];
-				mig_blk = ssd_pick_wear_aware_with_migration(bm.block_num, bm.rem_lifetime, avg_lifetime, mcost, bm.plane_num, elem_num, s);
-				if (ssd_pick_wear_aware(bm.block_num, bm.rem_lifetime, avg_lifetime, s)) {
-					lbn = i;
-					break;
-				}
-			}*/
-			lbn = i;
-		}
+	if (metadata->log_usage_min > max_usage) {
+		fprintf(outputfile3, "Error: we cannot find a log block to clean in elem %d\n", elem_num);
+		ASSERT(0);
+		exit(1);
 	}
 
-    return lbn;
+	return metadata->log_data[metadata->log_usage[metadata->log_usage_min]].lbn;
 }
 
 double _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
@@ -593,218 +519,20 @@ double _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_
     return cost;
 }
 
-static usage_table *ssd_build_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        int usage = metadata->block_usage[i].num_valid;
-        table[usage].len ++;
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        usage_table *entry;
-        int usage = metadata->block_usage[i].num_valid;
-
-        entry = &(table[usage]);
-        entry->block[entry->temp ++] = i;
-    }
-
-    return table;
-}
-
-static void ssd_release_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
-static usage_table *ssd_build_log_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-	int reserved_blocks_per_plane = (s->params.reserve_blocks * s->params.blocks_per_plane) / 100;
-	int reserved_blocks = reserved_blocks_per_plane * s->params.planes_per_pkg;  
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < reserved_blocks; i ++) {
-		int usage;
-		int block;
-		if(metadata->log_data[i].bsn != -1){
-			block = metadata->log_data[i].bsn;
-			usage = metadata->block_usage[block].num_valid;
-			table[usage].len ++;
-		}
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < reserved_blocks; i ++) {
-        usage_table *entry;
-        int usage;
-		int block;
-		if(metadata->log_data[i].bsn != -1){
-			block = metadata->log_data[i].bsn;
-			usage = metadata->block_usage[block].num_valid;
-			entry = &(table[usage]);
-			entry->block[entry->temp ++] = block;
-		}
-    }
-
-    return table;
-}
-
-static void ssd_release_log_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
-#define GREEDY_IN_COPYBACK 0
-
 /*
- * first we create a hash table of blocks according to their
- * usage. then we select blocks with the least usage and clean
- * them.
+ * 1. find a plane to clean in each of the parallel unit
+ * 2. invoke copyback cleaning on all such planes simultaneously
  */
-static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
-{
-    double cost = 0;
-    double avg_lifetime;
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    /////////////////////////////////////////////////////////////////////////////
-    // build the histogram
-    table = ssd_build_usage_table(elem_num, s);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    /////////////////////////////////////////////////////////////////////////////
-    // we now have a hash table of blocks, where the key of each
-    // bucket is the usage count and each bucket has all the blocks with
-    // the same usage count (i.e., the same num of valid pages).
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        int j;
-        usage_table *entry;
-
-        // get the bucket of blocks with 'i' valid pages
-        entry = &(table[i]);
-
-        // free all the blocks with 'i' valid pages
-        for (j = 0; j < entry->len; j ++) {
-            int blk = entry->block[j];
-            int block_life = metadata->block_usage[blk].rem_lifetime;
-
-            // if this is plane specific cleaning, then skip all the
-            // blocks that don't belong to this plane.
-            if ((plane_num != -1) && (metadata->block_usage[blk].plane_num != plane_num)) {
-                continue;
-            }
-
-            // if the block is already dead, skip it
-            if (block_life == 0) {
-                continue;
-            }
-
-            // clean only those blocks that are sealed.
-            if (ssd_can_clean_block(s, metadata, blk)) {
-
-                // if we care about wear-leveling, then we must rate limit overly cleaned blocks
-                if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
-
-                    // see if this block's remaining lifetime is within
-                    // a certain threshold of the average remaining lifetime
-                    // of all blocks in this element
-                    if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
-                        // we have to rate limit this block as it has exceeded
-                        // its cleaning limits
-                        printf("Rate limiting block %d (block life %d avg life %f\n",
-                            blk, block_life, avg_lifetime);
-
-                        if (ssd_rate_limit(block_life, avg_lifetime)) {
-                            // skip this block and go to the next one
-                            continue;
-                        }
-                    }
-                }
-
-                // okies, finally here we're with the block to be cleaned.
-                // invoke cleaning until we reach the high watermark.
-                cost += _ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
-
-                if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-                    // no more cleaning is required -- so quit.
-                    break;
-                }
-            }
-        }
-
-        if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-            // no more cleaning is required -- so quit.
-            break;
-        }
-    }
-
-    // release the table
-    ssd_release_usage_table(table, s);
-
-    // see if we were able to generate enough free blocks
-    if (!ssd_stop_cleaning(plane_num, elem_num, s)) {
-        printf("Yuck! we couldn't generate enough free pages in plane %d elem %d ssd %d\n",
-            plane_num, elem_num, s->devno);
-    }
-
-    return cost;
-}
 
 /*
- * 1. find a plane to clean in each of the parallel unit
- * 2. invoke copyback cleaning on all such planes simultaneously
+ * the flash energy spent so far by an element. the merges take it
+ * before and after they run to account their own energy.
  */
+static double ssd_merge_energy(ssd_power_element_stat *power_stat)
+{
+	return (power_stat->read_power_consumed + power_stat->write_power_consumed +
+		power_stat->erase_power_consumed + power_stat->bus_power_consumed);
+}
 
 double ssd_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_stat *power_stat, int lbn, int elem_num)
 {
@@ -821,6 +549,7 @@ double ssd_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element
 	int active_block;
 	int i;
 	double cost = 0.0;
+	double energy = ssd_merge_energy(power_stat);
 	double r_cost, w_cost, xfer_cost;
 
 	//set active_block
@@ -846,6 +575,7 @@ double ssd_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element
 
 	//update stat
 	//update log_table
+	ssd_log_usage_remove(log_index, metadata);
 	metadata->block_usage[prev_block].log_index = -1;
 	metadata->log_data[log_index].bsn = -1;
 	metadata->log_data[log_index].data_block = -1;
@@ -909,6 +639,7 @@ double ssd_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element
 	s->elements[elem_num].stat.pages_moved += num_valid;
 	s->elements[elem_num].stat.num_clean += 2;
 	s->elements[elem_num].stat.num_fullmerge++;
+	s->elements[elem_num].stat.fullmerge_energy += ssd_merge_energy(power_stat) - energy;
 
 	return cost;
 }
@@ -926,6 +657,7 @@ double ssd_switch(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_st
 
 	int i;
 	double cost = 0.0;
+	double energy = ssd_merge_energy(power_stat);
 
 	metadata->plane_meta[d_plane_num].clean_in_block = d_block;
 	metadata->plane_meta[d_plane_num].clean_in_progress = 1;
@@ -938,6 +670,7 @@ double ssd_switch(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_st
 	metadata->lba_table[lbn] = log_block;
 
 	//update stat
+	ssd_log_usage_remove(log_index, metadata);
 	metadata->block_usage[d_block].log_index = -1;
 	metadata->log_data[log_index].bsn = -1;
 	metadata->log_data[log_index].data_block = -1;
@@ -958,6 +691,7 @@ double ssd_switch(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_st
 	metadata->plane_meta[d_plane_num].num_cleans++;
 	s->elements[elem_num].stat.num_clean++;
 	s->elements[elem_num].stat.num_switch++;
+	s->elements[elem_num].stat.switch_energy += ssd_merge_energy(power_stat) - energy;
 
 	return cost;
 }
@@ -1029,11 +763,13 @@ double ssd_replacement(ssd_t *s, int elem_num, int lbn)
 	int plane_num;
 	int num_valid;
 	double cost = 0.0;
+	double energy;
 	double r_cost, w_cost, xfer_cost;
 	int i,j;
 
 	metadata = &(s->elements[elem_num].metadata);
 	power_stat = &(s->elements[elem_num].power_stat);
+	energy = ssd_merge_energy(power_stat);
 
 	block = metadata->lba_table[lbn];
 	log_index = metadata->block_usage[block].log_index;
@@ -1058,6 +794,7 @@ double ssd_replacement(ssd_t *s, int elem_num, int lbn)
 		metadata->block_usage[prev_log_block].page[i] = -1;
 	}
 	metadata->block_usage[prev_log_block].num_valid = 0;
+	ssd_log_usage_update(log_index, metadata, s);
 
 	//plane metadata update
 	metadata->plane_meta[prev_plane_num].valid_pages -= metadata->block_usage[log_block].num_valid;
@@ -1090,12 +827,384 @@ double ssd_replacement(ssd_t *s, int elem_num, int lbn)
 	s->elements[elem_num].stat.pages_moved += num_valid;
 	s->elements[elem_num].stat.num_clean ++;
 	s->elements[elem_num].stat.num_replacement++;
+	s->elements[elem_num].stat.replacement_energy += ssd_merge_energy(power_stat) - energy;
 	metadata->plane_meta[prev_plane_num].num_cleans++;
 
 	return cost;
 
 }
 
+/*
+ * fast: completes the sequential log with the pages it misses, from the
+ * data block and the random write logs, and switches it with the data
+ * block, which is erased.
+ */
+static double ssd_partialmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_stat *power_stat, int elem_num)
+{
+	int ppb = s->params.pages_per_block;
+	int lbn = metadata->sw_lbn;
+	int d_block = metadata->lba_table[lbn];
+	int log_index = metadata->sw_log;
+	int log_block = metadata->log_data[log_index].bsn;
+	int d_plane_num = metadata->block_usage[d_block].plane_num;
+	int log_plane_num = metadata->block_usage[log_block].plane_num;
+	int num_valid = 0;
+	int from_blk;
+	int lpn;
+	int i;
+	double cost = 0.0;
+	double energy = ssd_merge_energy(power_stat);
+	double r_cost, w_cost, xfer_cost;
+
+	metadata->plane_meta[d_plane_num].clean_in_block = d_block;
+	metadata->plane_meta[d_plane_num].clean_in_progress = 1;
+
+	//copy the pages behind the log, in order
+	for( i = metadata->sw_next ; i < ppb ; i++) {
+		lpn = lbn * ppb + i;
+		if (metadata->block_usage[d_block].page[i] == 1) {
+			from_blk = d_block;
+		} else if (metadata->rw_map[lpn] != -1) {
+			from_blk = metadata->log_data[metadata->rw_map[lpn] / ppb].bsn;
+		} else {
+			continue;
+		}
+
+		ssd_fast_invalidate(s, metadata, lbn, i);
+		metadata->block_usage[log_block].page[i] = 1;
+		metadata->block_usage[log_block].num_valid++;
+		metadata->plane_meta[log_plane_num].valid_pages++;
+
+		xfer_cost = ssd_crossover_cost(s, metadata, power_stat, from_blk, log_block);
+		cost += xfer_cost;
+		s->elements[elem_num].stat.tot_xfer_cost += xfer_cost;
+		num_valid++;
+	}
+	ASSERT(metadata->block_usage[d_block].num_valid == 0);
+
+	//read
+	r_cost = s->params.page_read_latency * num_valid;
+	cost += r_cost;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_READ, r_cost, power_stat, s);
+
+	//write
+	w_cost = s->params.page_write_latency * num_valid;
+	cost += w_cost;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_WRITE, w_cost, power_stat, s);
+
+	//the log becomes the data block
+	for( i = 0 ; i < ppb ; i++) {
+		metadata->block_usage[d_block].page[i] = -1;
+		metadata->log_data[log_index].page[i] = -1;
+	}
+	metadata->lba_table[lbn] = log_block;
+
+	ssd_log_usage_remove(log_index, metadata);
+	metadata->block_usage[d_block].log_index = -1;
+	metadata->log_data[log_index].bsn = -1;
+	metadata->log_data[log_index].data_block = -1;
+	metadata->log_data[log_index].lbn = -1;
+	metadata->num_log--;
+	metadata->log_pos = log_index;
+
+	//erase the data block
+	cost += s->params.block_erase_latency;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_ERASE, s->params.block_erase_latency, power_stat, s);
+	ssd_update_free_block_status(d_block, d_plane_num, metadata, s);
+	ssd_update_block_lifetime(simtime+cost, d_block, metadata);
+	metadata->plane_meta[d_plane_num].clean_in_block = 0;
+	metadata->plane_meta[d_plane_num].clean_in_progress = -1;
+	metadata->plane_meta[d_plane_num].num_cleans++;
+
+	s->elements[elem_num].stat.pages_moved += num_valid;
+	s->elements[elem_num].stat.num_clean++;
+	s->elements[elem_num].stat.num_partialmerge++;
+	s->elements[elem_num].stat.partialmerge_energy += ssd_merge_energy(power_stat) - energy;
+
+	return cost;
+}
+
+/*
+ * fast: merges the sequential log. a log written in order up to its last
+ * page is switched with the data block, the others are partially merged.
+ */
+static double ssd_fast_merge_sequential(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_stat *power_stat, int elem_num)
+{
+	double cost;
+
+	if (metadata->sw_next == s->params.pages_per_block) {
+		cost = ssd_switch(s, metadata, power_stat, metadata->sw_lbn, elem_num);
+	} else {
+		cost = ssd_partialmerge(s, metadata, power_stat, elem_num);
+	}
+
+	metadata->sw_log = -1;
+	metadata->sw_lbn = -1;
+	metadata->sw_next = 0;
+
+	return cost;
+}
+
+/*
+ * fast: merges the pages of a logical block, spread over its data block
+ * and the random write logs, into a new data block. the old data block
+ * is erased, the random write logs are erased when they are reclaimed.
+ */
+static double ssd_fast_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_stat *power_stat, int lbn, int elem_num)
+{
+	int ppb = s->params.pages_per_block;
+	int prev_block = metadata->lba_table[lbn];
+	int prev_plane_num = metadata->block_usage[prev_block].plane_num;
+	int num_valid = 0;
+	int active_block;
+	int plane_num;
+	int from_blk;
+	int lpn;
+	int i;
+	double cost = 0.0;
+	double energy = ssd_merge_energy(power_stat);
+	double r_cost, w_cost, xfer_cost;
+
+	ASSERT(metadata->block_usage[prev_block].log_index == -1);
+
+	//set active_block
+	metadata->active_block = metadata->plane_meta[prev_plane_num].active_block;
+	active_block = metadata->active_block;
+	_ssd_alloc_active_block(prev_plane_num, elem_num, s);
+	plane_num = metadata->block_usage[active_block].plane_num;
+	metadata->plane_meta[prev_plane_num].clean_in_block = prev_block;
+	metadata->plane_meta[prev_plane_num].clean_in_progress = 1;
+
+	//gather the valid pages at their offsets
+	for( i = 0 ; i < ppb ; i++) {
+		lpn = lbn * ppb + i;
+		if (metadata->block_usage[prev_block].page[i] == 1) {
+			from_blk = prev_block;
+		} else if (metadata->rw_map[lpn] != -1) {
+			from_blk = metadata->log_data[metadata->rw_map[lpn] / ppb].bsn;
+		} else {
+			continue;
+		}
+
+		ssd_fast_invalidate(s, metadata, lbn, i);
+		metadata->block_usage[active_block].page[i] = 1;
+
+		xfer_cost = ssd_crossover_cost(s, metadata, power_stat, from_blk, active_block);
+		cost += xfer_cost;
+		s->elements[elem_num].stat.tot_xfer_cost += xfer_cost;
+		num_valid++;
+	}
+	ASSERT(metadata->block_usage[prev_block].num_valid == 0);
+
+	for( i = 0 ; i < ppb ; i++) {
+		metadata->block_usage[prev_block].page[i] = -1;
+	}
+	metadata->lba_table[lbn] = active_block;
+	metadata->block_usage[active_block].num_valid = num_valid;
+	metadata->plane_meta[plane_num].valid_pages += num_valid;
+
+	//read
+	r_cost = s->params.page_read_latency * num_valid;
+	cost += r_cost;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_READ, r_cost, power_stat, s);
+
+	//write
+	w_cost = s->params.page_write_latency * num_valid;
+	cost += w_cost;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_WRITE, w_cost, power_stat, s);
+
+	//erase the data block
+	cost += s->params.block_erase_latency;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_ERASE, s->params.block_erase_latency, power_stat, s);
+	ssd_update_free_block_status(prev_block, prev_plane_num, metadata, s);
+	ssd_update_block_lifetime(simtime+cost, prev_block, metadata);
+	metadata->plane_meta[prev_plane_num].num_cleans++;
+	metadata->plane_meta[prev_plane_num].clean_in_block = 0;
+	metadata->plane_meta[prev_plane_num].clean_in_progress = -1;
+
+	s->elements[elem_num].stat.pages_moved += num_valid;
+	s->elements[elem_num].stat.num_clean++;
+	s->elements[elem_num].stat.num_fullmerge++;
+	s->elements[elem_num].stat.fullmerge_energy += ssd_merge_energy(power_stat) - energy;
+
+	return cost;
+}
+
+/*
+ * fast: returns 1 if the oldest random write log of set 'a' is to be
+ * reclaimed before that of set 'b'. a log that is full goes before one
+ * still being written, and then the lower bsn, the older log, goes first.
+ */
+static int ssd_fast_set_before(ssd_t *s, ssd_element_metadata *metadata, int a, int b)
+{
+	log_set *sa = &metadata->rw_sets[a];
+	log_set *sb = &metadata->rw_sets[b];
+	int full_a = (sa->head != sa->tail) || (sa->page == s->params.pages_per_block);
+	int full_b = (sb->head != sb->tail) || (sb->page == s->params.pages_per_block);
+
+	if (full_a != full_b) {
+		return full_a;
+	}
+	return (sa->head_bsn < sb->head_bsn);
+}
+
+static void ssd_fast_heap_swap(ssd_element_metadata *metadata, int i, int j)
+{
+	int set = metadata->rw_heap[i];
+
+	metadata->rw_heap[i] = metadata->rw_heap[j];
+	metadata->rw_heap[j] = set;
+	metadata->rw_sets[metadata->rw_heap[i]].heap_pos = i;
+	metadata->rw_sets[metadata->rw_heap[j]].heap_pos = j;
+}
+
+static void ssd_fast_heap_up(ssd_t *s, ssd_element_metadata *metadata, int i)
+{
+	while ((i > 0) && ssd_fast_set_before(s, metadata, metadata->rw_heap[i], metadata->rw_heap[(i - 1) / 2])) {
+		ssd_fast_heap_swap(metadata, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+static void ssd_fast_heap_down(ssd_t *s, ssd_element_metadata *metadata, int i)
+{
+	int child;
+
+	while ((child = 2 * i + 1) < metadata->rw_heap_size) {
+		if ((child + 1 < metadata->rw_heap_size) &&
+			ssd_fast_set_before(s, metadata, metadata->rw_heap[child + 1], metadata->rw_heap[child])) {
+			child ++;
+		}
+		if (!ssd_fast_set_before(s, metadata, metadata->rw_heap[child], metadata->rw_heap[i])) {
+			break;
+		}
+		ssd_fast_heap_swap(metadata, i, child);
+		i = child;
+	}
+}
+
+/*
+ * fast: puts a set back in its place in rw_heap after its logs have
+ * changed. a set takes a place when it gets its first log and leaves
+ * when its last log is reclaimed, so the heap only holds the sets
+ * that have logs, the one to reclaim from on top.
+ */
+void ssd_fast_set_update(ssd_t *s, ssd_element_metadata *metadata, int set_num)
+{
+	log_set *set = &metadata->rw_sets[set_num];
+	int i = set->heap_pos;
+
+	if (set->head == -1) {
+		if (i == -1) {
+			return;
+		}
+		set->heap_pos = -1;
+		metadata->rw_heap_size --;
+		if (i < metadata->rw_heap_size) {
+			metadata->rw_heap[i] = metadata->rw_heap[metadata->rw_heap_size];
+			metadata->rw_sets[metadata->rw_heap[i]].heap_pos = i;
+			ssd_fast_heap_up(s, metadata, i);
+			ssd_fast_heap_down(s, metadata, metadata->rw_sets[metadata->rw_heap[i]].heap_pos);
+		}
+		return;
+	}
+
+	set->head_bsn = metadata->block_usage[metadata->log_data[set->head].bsn].bsn;
+	if (i == -1) {
+		i = metadata->rw_heap_size ++;
+		metadata->rw_heap[i] = set_num;
+		set->heap_pos = i;
+	}
+	ssd_fast_heap_up(s, metadata, i);
+	ssd_fast_heap_down(s, metadata, set->heap_pos);
+}
+
+/*
+ * fast: picks the set whose oldest random write log is reclaimed to make
+ * room for a write of logical block 'lbn'. a set that holds as many logs
+ * as it may reclaims its own, otherwise the log area is used up and the
+ * set on top of rw_heap gives up its oldest log.
+ */
+static int ssd_fast_pick_set(ssd_t *s, ssd_element_metadata *metadata, int lbn)
+{
+	int set = lbn / metadata->rw_assoc;
+
+	if (metadata->rw_sets[set].count == metadata->rw_set_max) {
+		return set;
+	}
+
+	ASSERT(metadata->rw_heap_size > 0);
+	return metadata->rw_heap[0];
+}
+
+/*
+ * fast: reclaims the oldest random write log of a set. every logical
+ * block with a valid page in it is merged, and the log, left with no
+ * valid page, is erased. the erase is part of the cost of the full merges.
+ */
+static double ssd_fast_reclaim(ssd_t *s, int elem_num, int set_num)
+{
+	ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
+	ssd_power_element_stat *power_stat = &(s->elements[elem_num].power_stat);
+	log_set *set = &metadata->rw_sets[set_num];
+	int ppb = s->params.pages_per_block;
+	int log_index = set->head;
+	int log_block = metadata->log_data[log_index].bsn;
+	int plane_num = metadata->block_usage[log_block].plane_num;
+	int lbn;
+	int i;
+	double cost = 0.0;
+	double energy;
+
+	ASSERT(set->count > 0);
+
+	for( i = 0 ; i < ppb ; i++) {
+		if (metadata->block_usage[log_block].page[i] != 1) {
+			continue;
+		}
+
+		lbn = metadata->log_data[log_index].page[i] / ppb;
+		if (lbn == metadata->sw_lbn) {
+			cost += ssd_fast_merge_sequential(s, metadata, power_stat, elem_num);
+		} else {
+			cost += ssd_fast_fullmerge(s, metadata, power_stat, lbn, elem_num);
+		}
+	}
+	ASSERT(metadata->block_usage[log_block].num_valid == 0);
+
+	energy = ssd_merge_energy(power_stat);
+	for( i = 0 ; i < ppb ; i++) {
+		metadata->block_usage[log_block].page[i] = -1;
+		metadata->log_data[log_index].page[i] = -1;
+	}
+
+	//erase the log block
+	cost += s->params.block_erase_latency;
+	ssd_power_flash_calculate(SSD_POWER_FLASH_ERASE, s->params.block_erase_latency, power_stat, s);
+	ssd_update_free_block_status(log_block, plane_num, metadata, s);
+	ssd_update_block_lifetime(simtime+cost, log_block, metadata);
+	metadata->plane_meta[plane_num].num_cleans++;
+	s->elements[elem_num].stat.num_clean++;
+	s->elements[elem_num].stat.num_log_reclaim++;
+	s->elements[elem_num].stat.fullmerge_energy += ssd_merge_energy(power_stat) - energy;
+
+	metadata->log_data[log_index].bsn = -1;
+	metadata->log_pos = log_index;
+	metadata->num_log--;
+
+	set->head = metadata->log_data[log_index].set_next;
+	metadata->log_data[log_index].set_next = -1;
+	set->count--;
+	if (set->head == -1) {
+		set->tail = -1;
+		set->page = ppb;
+	}
+	metadata->rw_total--;
+	ssd_fast_set_update(s, metadata, set_num);
+
+	return cost;
+}
+
 double ssd_clean_element(ssd_t *s, int elem_num)
 {
 	ssd_element_metadata *metadata;
@@ -1130,6 +1239,15 @@ double ssd_clean_logblock(ssd_t *s, int elem_num, int lbn)
 	int i;
 
 	metadata = &(s->elements[elem_num].metadata);
+
+	//fast: merge the sequential log of the block, or reclaim a random write log
+	if (s->params.log_block_mapping == SSD_LOG_BLOCK_FAST) {
+		if (lbn == metadata->sw_lbn) {
+			return ssd_fast_merge_sequential(s, metadata, &(s->elements[elem_num].power_stat), elem_num);
+		}
+		return ssd_fast_reclaim(s, elem_num, ssd_fast_pick_set(s, metadata, lbn));
+	}
+
 	block = metadata->lba_table[lbn];
 	for( i = 0 ; i < s->params.pages_per_block ; i++){
 		if(metadata->block_usage[block].page[i] != -1)
@@ -21,12 +21,76 @@ extern struct device_header ssd_hdr_initializer;
 #define SSD_MAX_ELEMS_PER_GANG      SSD_MAX_ELEMENTS// if you're changing this, do change the following bits too
 #define SSD_BITS_ELEMS_PER_GANG     8
 
+/*
+ * a log-linear histogram of times (in ms). the times are counted in
+ * units of SSD_HIST_UNIT. below 2^SSD_HIST_SUB_BITS units each unit has
+ * its own bucket, and above that each power of two is split into
+ * 2^SSD_HIST_SUB_BITS buckets. so a value is recorded in constant time
+ * and the percentiles are within 2^-SSD_HIST_SUB_BITS of the exact ones.
+ */
+#define SSD_HIST_UNIT               0.0001  // ms
+#define SSD_HIST_SUB_BITS           5
+#define SSD_HIST_MAX_BITS           40      // times up to 2^40 units (about 30 hours)
+#define SSD_HIST_SUB_BUCKETS        (1 << SSD_HIST_SUB_BITS)
+#define SSD_HIST_BUCKETS            ((SSD_HIST_MAX_BITS - SSD_HIST_SUB_BITS + 1) * SSD_HIST_SUB_BUCKETS)
+
+typedef struct _ssd_hist {
+    long long count;
+    double sum;
+    double max;
+    int buckets[SSD_HIST_BUCKETS];
+} ssd_hist;
+
+/*
+ * the response time of a request is broken down into the phases below.
+ * the element phases of a request that spans several pages are those of
+ * the page that completes last.
+ */
+typedef enum {
+    SSD_LAT_QUEUE,                  // waiting in the ssd queue
+    SSD_LAT_CHANNEL,                // channel/way delay until the element is activated
+    SSD_LAT_ELEMENT,                // waiting in the element queue
+    SSD_LAT_GC,                     // waiting for the cleaning of the element
+    SSD_LAT_ARRAY,                  // flash array and chip transfer
+    SSD_LAT_XFER,                   // transfer on the host bus and completion
+    SSD_LAT_PHASES
+} ssd_lat_phase_t;
+
+#define SSD_LAT_READ                0
+#define SSD_LAT_WRITE               1
+
+/*
+ * latency histograms kept for each ssd and each of its elements. for an
+ * element, the read and write times are those of the host pages it
+ * serves, from the time they are queued on it until they are over.
+ */
+typedef struct _ssd_lat_stat {
+    ssd_hist read;                  // response time of the host reads
+    ssd_hist write;                 // and of the host writes
+    ssd_hist gc;                    // duration of each cleaning
+    ssd_hist queue_wait;            // time the pages wait in the element queues
+} ssd_lat_stat;
 
 typedef struct {
    statgen acctimestats;
    double  requestedbus;
    double  waitingforbus;
    int     numbuswaits;
+   int     cache_read_hits;         // pages read from the buffer cache
+   int     cache_read_misses;
+   int     cache_write_hits;        // pages overwritten in the buffer cache
+   int     cache_write_misses;
+   int     cache_destages;          // batches of dirty pages destaged
+   int     cache_pages_destaged;
+   int     cache_prefetches;        // pages read ahead into the buffer cache
+   int     cache_prefetch_hits;     // pages read ahead and then read
+   int     cache_prefetch_wasted;   // pages read ahead and evicted or overwritten unread
+   int     activates_folded;        // element activations folded into a pending one
+   int     max_completion_qlen;     // high-water mark of the completion queue
+   int     reqs_pooled;             // ssd_req objects handed out by the request pool
+   int     req_allocs;              // ssd_req objects that had to come from the heap
+   ssd_lat_stat lat;                // latency histograms of the ssd
+   ssd_hist lat_phase[2][SSD_LAT_PHASES];   // breakdown of the read and write response times
 } ssd_stat_t;
 
 /*
@@ -44,6 +108,12 @@ typedef struct _ssd_element_stat {
 	int num_fullmerge;
 	int num_switch;
 	int num_replacement;
+	int num_partialmerge;           // fast: sequential logs completed from their data block
+	int num_log_reclaim;            // fast: random write logs reclaimed
+	double fullmerge_energy;        // flash energy (read, write, erase and transfers)
+	double switch_energy;           // spent by each kind of merge
+	double partialmerge_energy;
+	double replacement_energy;
 	int tot_read_reqs;
 	int tot_write_reqs;
 } ssd_element_stat;
@@ -64,8 +134,26 @@ typedef struct _log_data{
 	int bsn;	//physical block number
 	int data_block;
 	int *page;	//save page offset
+	int lbn;	//logical block this log block belongs to
+	int usage;	//valid pages in the data and log blocks, -1 if not in the log usage table
+	int usage_prev;	//previous and next log index on the same log usage list
+	int usage_next;
+	int set_next;	//fast: next random write log of the same set, -1 if it is the newest
 } log_table;
 
+/*
+ * fast: the random write log blocks shared by a set of data blocks,
+ * oldest first.
+ */
+typedef struct _log_set {
+	int head;		//oldest and newest log index, -1 if the set has no log
+	int tail;
+	int count;
+	int page;		//next page to write in the newest log
+	unsigned int head_bsn;	//bsn of the oldest log
+	int heap_pos;	//position in rw_heap, -1 if the set has no log
+} log_set;
+
 /*
  * this is the metadata stored on each block.
  * it contains a list of valid pages (in the real system,
@@ -129,10 +217,19 @@ typedef struct _plane_metadata {
     int block_alloc_pos;            // block allocation position in a plane
     int parunit_num;                // parallel unit number
     int num_cleans;                 // number of times cleaning was invoked on this
+    int queued_writes;              // num of writes already queued on this plane in the
+                                    // batch that is being issued
+    long long tot_erasures;         // total num of erasures performed on the blocks
+                                    // of this plane
 } plane_metadata;
 
 typedef struct _parunit {
     int plane_to_clean;
+
+    struct _ssd_req **ring;         // requests queued on this parallel unit while a batch
+                                    // is issued. size of the array = MAX_REQS_ELEM_QUEUE
+    int ring_head;                  // position of the next request to issue
+    int ring_count;                 // num of requests in the queue
 } parunit;
 
 /*
@@ -143,10 +240,31 @@ typedef struct _ssd_element_metadata {
     int *lba_table;                 // a table mapping the lba to the physical pages
                                     // on the chip.
 	log_table *log_data;
+	int *log_page_table;			// the page entries of all the log blocks, the page
+									// array of each log_data entry points into this table
 	int num_log;					// number of log blocks
 	int log_pos;					// start allocating block from this position
-
-    char *free_blocks;              // each bit indicates whether a block in the
+	int *log_usage;					// log usage table: heads of the lists of log blocks indexed
+									// by the valid pages of their data and log blocks.
+									// size of the array = 2 * pages_per_block + 1
+	int log_usage_min;				// all the log usage lists below this index are empty
+
+	int sw_log;						// fast: log index of the sequential log block, -1 if none
+	int sw_lbn;						// logical block written to it
+	int sw_next;					// offset it takes next
+	log_set *rw_sets;				// fast: random write logs of each set of rw_assoc
+	int num_sets;					// consecutive logical blocks
+	int rw_assoc;
+	int rw_set_max;					// most random write logs of a set
+	int rw_max;						// most random write logs of the element
+	int rw_total;
+	int *rw_heap;					// fast: the sets that hold random write logs, a min-heap
+	int rw_heap_size;				// on the age of their oldest log (see ssd_fast_set_update)
+	int *rw_map;					// fast: random write log page (log index * pages_per_block
+									// + page) holding each logical page of the element, -1
+									// if the page is in its data block or sequential log
+
+    struct _ssd_bitmap *free_blocks;    // each bit indicates whether a block in the
                                     // ssd_element is free or in use. number of bits
                                     // in free_blocks is given by
                                     // (struct ssd*)->params.blocks_per_element
@@ -164,6 +282,10 @@ typedef struct _ssd_element_metadata {
                                     // we also store the valid page numbers here. this is useful
                                     // during cleaning.
 
+    int *page_table;                // the page entries of all the blocks in this element,
+                                    // indexed by physical page number. the page array of
+                                    // each block in block_usage points into this table.
+
     unsigned int bsn;               // block sequence number for this ssd element
 
     int plane_to_clean;             // which plane to clean?
@@ -177,6 +299,10 @@ typedef struct _ssd_element_metadata {
     int tot_migrations;             //
     int tot_pgs_migrated;           //
     double mig_cost;                //
+
+    long long tot_erasures;         // running wear statistics: the total num of erasures
+    long long tot_erasures_sqr;     // and the sum of squares of the per-block erasure
+                                    // counts in this element
 } ssd_element_metadata;
 
 /*
@@ -208,6 +334,9 @@ typedef struct _ssd_power_element_stat {
 
 	//tiel
 	double acc_time;
+
+	double profile_energy;			// energy already placed on the power profile
+	double profile_start;			// time at which the next operations start
 } ssd_power_element_stat;
 
 /*
@@ -216,8 +345,29 @@ typedef struct _ssd_power_element_stat {
 typedef struct _ssd_power_ssd_stat {
 	double ssd_bus_power_consumed;
 	double ssd_bus_time_consumed;
+	double dram_power_consumed;		// active energy of the dram
+	double dram_time_consumed;
 } ssd_power_ssd_stat;
 
+/*
+ * running energy totals of a ssd. they are updated as the energy of each
+ * operation gets accounted, so that power_update does not have to go over
+ * all the elements. the voltage x current products are computed once.
+ */
+typedef struct _ssd_power_totals {
+	double read_power;				// flash_input_voltage * page_read_current
+	double write_power;				// flash_input_voltage * page_write_current
+	double erase_power;				// flash_input_voltage * page_erase_current
+	double flash_bus_power;			// flash_input_voltage * flash_bus_current
+	double flash_idle_power;		// flash_input_voltage * flash_idle_current
+	double ssd_bus_power;			// bus voltage * ssd_bus_current
+	double ctrl_current;			// current drawn by the controller, dram and leakage
+
+	double flash_energy;			// read, write, erase and bus energy of all the elements
+	double elem_acc_time;			// sum of the access times of all the elements
+	int busy_elements;				// num of elements whose media is busy
+} ssd_power_totals;
+
 typedef struct _ssd_power_list {
 	double time;
 	double energy;
@@ -225,6 +375,65 @@ typedef struct _ssd_power_list {
 	double current;
 	double cost;
 } ssd_power_section;
+
+/*
+ * with a sampling period, the power timeline has one record per period
+ * instead of one per event. the energy drawn above the idle power is
+ * spread over the bins of the periods in which it is drawn, and the
+ * current is integrated over each period.
+ */
+typedef struct _ssd_power_sampler {
+	double base_power;				// power drawn when every element is idle
+	double active_energy;			// energy above base_power already put into the bins
+	double *bins;					// energy above base_power of the upcoming periods
+	int nbins;						// allocated bins (a power of 2)
+	int first;						// bin of the period starting at 'start'
+	double start;					// start time of the first period not yet recorded
+	double current_sum;				// current integrated from 'start' to 'current_time'
+	double current_time;
+	double end;						// end of the latest energy spread into the bins
+} ssd_power_sampler;
+
+/*
+ * the power profile keeps the exact power curve of the ssd. each
+ * flash operation, bus transfer and cpu activity adds a (start, end,
+ * current) interval as two edges into a heap ordered by time. the
+ * edges before simtime are swept in order, as the later intervals
+ * can only start after simtime.
+ */
+#define SSD_POWER_PROFILE_OFF			0
+#define SSD_POWER_PROFILE_STATS			1	// peak, percentile and budget statistics
+#define SSD_POWER_PROFILE_CURVE			2	// also write the curve to the power timeline
+
+#define SSD_POWER_PROFILE_BINS			1024
+
+typedef struct _ssd_power_edge {
+	double time;
+	double current;					// change of the current at 'time'
+	double power;					// change of the power at 'time'
+} ssd_power_edge;
+
+typedef struct _ssd_power_profile {
+	ssd_power_edge *edges;			// heap of the edges not swept yet
+	int num_edges;
+	int max_edges;
+	double *channel_free;			// per channel, the end of its last transfer
+
+	double time;					// the curve is known up to this time
+	double current;					// current and power from 'time' on
+	double power;
+	double level_start;				// start of the level being written out
+	double level_current;
+	double level_power;
+
+	double peak_power;
+	double peak_current;
+	double peak_time;
+	double over_budget;				// time spent above the power budget
+	double tot_time;
+	double bin_width;				// power covered by a bin of 'hist'
+	double hist[SSD_POWER_PROFILE_BINS];	// time spent at each power
+} ssd_power_profile;
 /*
  * the ssd element (a single package) internally consists of multiple
  * planes and the entire package has only one set of pins. so, when
@@ -242,8 +451,15 @@ typedef struct _ssd_element {
    //--
 
    int pin_busy;                                // state to hold the busy state of the package pins
+   double clean_time;                           // time the element has been cleaning, up to
+   double clean_end;                            // the end of its last cleaning
+   ssd_lat_stat *lat;                           // latency histograms of the element
+   ioreq_event *activate;                       // the pending SSD_ACTIVATE_ELEM event, if any
    int num_planes;                              // number of planes in this package
    ssd_plane plane[SSD_MAX_PLANES_PER_ELEM];    // an array of flash planes
+
+   struct _ssd_req **read_reqs;                 // reads and writes collected when the element
+   struct _ssd_req **write_reqs;                // is activated (size = MAX_REQS_ELEM_QUEUE)
 } ssd_element;
 
 typedef struct _ssd_elem_number {
@@ -258,6 +474,8 @@ typedef struct _gang_metadata {
     double oldest;                              // time at which the oldest of the waiting reqs arrived
     int elem_free_pages[SSD_MAX_ELEMENTS];      // free pages on each element
     ssd_elem_number *pg2elem;
+    struct _ssd_req ***rd_q;                    // reads and writes collected from each element
+    struct _ssd_req ***wr_q;                    // when the gang is activated (MAX_REQS per element)
 } gang_metadata;
 
 //tiel
@@ -336,13 +554,25 @@ typedef struct _channel_data{
 #define SSD_ALLOC_POOL_CHIP                     1   // each element is an allocation pool
 #define SSD_ALLOC_POOL_PLANE                    2
 
+// how the log blocks are associated with the data blocks
+#define SSD_LOG_BLOCK_BAST                      0   // one log block per data block
+#define SSD_LOG_BLOCK_FAST                      1   // random write logs shared by all the
+                                                    // data blocks and one sequential log
+
 // what do the gangs share?
 #define SSD_SHARED_BUS_GANG                     1  // shares both data and control
 #define SSD_SHARED_CONTROL_GANG                 2  // shares only the control
 
 // buffer cache policy
 #define SSD_BUFFER_CACHE_NO_USE					0
-#define SSD_BUFFER_CACHE_USE_DRAM				1
+#define SSD_BUFFER_CACHE_USE_DRAM				1	// lru write-back buffer in the dram
+#define SSD_BUFFER_CACHE_CFLRU					2	// clean first lru
+
+// the requests the buffer cache sends to the elements on behalf of a
+// request carry this type, and the dram accesses this element number.
+// neither is seen by the rest of disksim.
+#define SSD_BUFFER_CACHE_REQ					(-1)
+#define SSD_BUFFER_CACHE_ELEM					(-1)
 
 
 typedef struct _ssd_timing_params {
@@ -413,11 +643,111 @@ typedef struct _ssd_timing_params {
 	double	dram_active_latency; // time to read/write a byte from/to register or external interface IO
 
 	int 	dram_cache_size; // bytes
+	double	dram_cache_window;	 // fraction of the buffer evicted clean first (cflru)
+	int		dram_destage_batch;	 // dirty pages destaged together
+	int		read_cache;			 // 1 keeps the pages read in the buffer cache
+	int		read_ahead;			 // pages read ahead of a sequential stream
 
 	double	leakage_power;
+	double	power_sample_period; // 0 records the power at every event
+	int		power_profile;		 // SSD_POWER_PROFILE_OFF, _STATS or _CURVE
+	double	power_budget;		 // mW, 0 if there is no budget
+	int		page_trace_sampling; // 0 disables the page trace, N traces 1 in N pages
+	int		latency_breakdown;	 // 1 breaks the response time down into phases
+	int		chrome_trace;		 // 1 writes the element and channel timelines
+	double	chrome_trace_start;	 // window of the timelines (ms), 0 end means
+	double	chrome_trace_end;	 // until the end of the run
+	int		self_profiling;		 // 1 times the event handlers and ftl entry points
+	int		log_block_mapping;	 // SSD_LOG_BLOCK_BAST or SSD_LOG_BLOCK_FAST
+	int		log_block_assoc;	 // fast: data blocks sharing a set of log blocks, 0 for all
+	int		log_blocks_per_set;	 // fast: most log blocks of a set, 0 for no limit
 	//--
 } ssd_timing_params;
 
+/*
+ * a pool of request objects preallocated for each ssd. the elements and
+ * gangs take their ssd_req objects from here when they are activated
+ * instead of allocating one for every request.
+ */
+typedef struct _ssd_req_pool {
+    struct _ssd_req *slab;          // the preallocated request objects
+    struct _ssd_req **free_list;    // stack of the unused objects in the slab
+    int size;                       // num of objects in the slab
+    int num_free;                   // num of objects on the free list
+} ssd_req_pool;
+
+/*
+ * an open addressing set of (blkno, flags) pairs that an element uses to
+ * spot duplicate requests while collecting its requests. a slot is in use
+ * only if its generation matches the set's, so the set is emptied for the
+ * next activation by just bumping the generation.
+ */
+typedef struct _ssd_dedup_slot {
+    int blkno;
+    int flags;
+    unsigned int gen;
+} ssd_dedup_slot;
+
+typedef struct _ssd_dedup_set {
+    ssd_dedup_slot *slots;          // size = SSD_DEDUP_SET_SIZE
+    unsigned int gen;               // current generation of the set
+} ssd_dedup_set;
+
+/*
+ * the times at which a request enters its phases. the record hangs off
+ * the ssd_lat field of the request from its arrival to its completion,
+ * and each of its pages carries a ssd_lat_page while it is queued on an
+ * element. both are recycled through free lists of the ssd.
+ */
+typedef struct _ssd_lat {
+    double arrive;                  // arrival at the ssd
+    double start;                   // the ssd starts serving the request
+    double media;                   // the pages are queued on the elements
+    double done;                    // the last page completes
+    double page_end;                // end of the latest page issued so far
+    int pages;                      // num of pages issued to the elements
+    double phase[SSD_LAT_PHASES];
+    struct _ssd_lat *next;
+} ssd_lat;
+
+typedef struct _ssd_lat_page {
+    double activate;                // the element is activated for this page
+    double queued;                  // the page is queued on the element
+    double cleaned;                 // cleaning time of the element when the page was queued
+    struct _ssd_lat_page *next;
+} ssd_lat_page;
+
+typedef struct _ssd_chrome_trace ssd_chrome_trace;   // see ssd_chrome_trace.c
+typedef struct _ssd_cache ssd_cache;                 // see ssd_cache.h
+
+/*
+ * self profiling of the simulator. the events handled by ssd_process_event
+ * and the calls to the ftl entry points are counted along with the wall
+ * clock time spent in them. the times of the entry points are part of the
+ * times of the events that call them.
+ */
+typedef enum {
+    SSD_PROF_REQUEST_ARRIVE,        // DEVICE_OVERHEAD_COMPLETE
+    SSD_PROF_ACCESS_COMPLETE,       // DEVICE_ACCESS_COMPLETE
+    SSD_PROF_TRANSFER_COMPLETE,     // DEVICE_DATA_TRANSFER_COMPLETE
+    SSD_PROF_INTERRUPT_COMPLETE,    // IO_INTERRUPT_COMPLETE
+    SSD_PROF_ACTIVATE_ELEM,         // SSD_ACTIVATE_ELEM
+    SSD_PROF_CLEAN_GANG,            // SSD_CLEAN_GANG
+    SSD_PROF_CLEAN_ELEMENT,         // SSD_CLEAN_ELEMENT
+    SSD_PROF_CLEAN_LOG,             // SSD_CLEAN_LOG (bast)
+    SSD_PROF_EVENTS,
+    SSD_PROF_ACCESS_TIME = SSD_PROF_EVENTS, // ssd_compute_access_time
+    SSD_PROF_CLEAN,                 // ssd_clean_element and ssd_clean_logblock
+    SSD_PROF_POWER,                 // ssd_dpower (power_update and the power profile)
+    SSD_PROF_ENTRIES
+} ssd_prof_entry_t;
+
+typedef struct _ssd_prof {
+    double start;                   // wall clock time of the initialization (s)
+    long long count[SSD_PROF_ENTRIES];
+    double wall[SSD_PROF_ENTRIES];  // s
+} ssd_prof;
+
 struct _ssd_timing_t;    // forward def for timing module.
 //typedef struct _ssd_timing_t *ssd_timing_t;
 
@@ -436,6 +766,8 @@ typedef struct ssd {
 
 	ioreq_event *channel_activity;
 	ioreq_event *completion_queue;
+	ioreq_event *completion_tail;	// last request on the completion queue
+	int completion_qlen;			// num of requests on the completion queue
 	struct ioq *queue;
 
 	ssd_element elements[SSD_MAX_ELEMENTS];
@@ -460,6 +792,9 @@ typedef struct ssd {
 	// add tiel
 	ssd_power_section power_section;
 	ssd_power_section *end_list;
+	ssd_power_totals power_totals;
+	ssd_power_sampler power_sampler;
+	ssd_power_profile *power_profile;
 	double acc_time;
 	double prev_time;
 	double prev_energy;
@@ -468,6 +803,13 @@ typedef struct ssd {
 	double current_cost;
 	double prev_cost;
 	channel CH[MAX_CHANNEL];
+	ssd_req_pool req_pool;
+	ssd_dedup_set dedup;
+	ssd_lat *lat_free;				// free latency records
+	ssd_lat_page *lat_page_free;
+	ssd_chrome_trace *chrome_trace;	// NULL unless the timelines are written
+	ssd_cache *cache;				// NULL unless the dram buffers the pages
+	ssd_prof prof;
 } ssd_t;
 
 typedef struct ssd_info {
@@ -507,6 +849,8 @@ typedef struct _ssd_req {
 #define MIN_REQS                    99999999
 #define MAX_REQS                    100
 #define MAX_REQS_ELEM_QUEUE         100
+#define SSD_DEDUP_SET_SIZE          512     // must be a power of 2 and well above 2 * MAX_REQS_ELEM_QUEUE
+#define SSD_REQ_POOL_SIZE(s)        (2 * MAX_REQS_ELEM_QUEUE + (s)->params.elements_per_gang)
 #define SYNC_GANG                   1
 #define MIGRATE                     1
 
@@ -524,11 +868,28 @@ double  _ssd_write_page_osr(ssd_t *s, ssd_element_metadata *metadata, int lpn, s
 int     ssd_block_to_bitpos(ssd_t *currdisk, int block);
 int     ssd_bitpos_to_block(int bitpos, ssd_t *s);
 void    _ssd_alloc_active_block(int plane_num, int elem_num, ssd_t *s);
+void    ssd_fast_invalidate(ssd_t *s, ssd_element_metadata *metadata, int lbn, int offset);
+void    ssd_fast_set_update(ssd_t *s, ssd_element_metadata *metadata, int set_num);
 int     ssd_free_bits(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s);
 double  ssd_read_policy_simple(int count, ssd_t *s, ssd_power_element_stat *power_stat);
 void    ssd_complete_parent(ioreq_event *curr, ssd_t *currdisk);
 double _ssd_invoke_element_cleaning(int elem_num, ssd_t *s);
 int     ssd_already_present(ssd_req **reqs, int total, ioreq_event *req);
+void    ssd_req_pool_init(ssd_t *s);
+ssd_req *ssd_req_get(ssd_t *s);
+void    ssd_req_put(ssd_t *s, ssd_req *r);
+void    ssd_dedup_init(ssd_t *s);
+
+void    ssd_hist_add(ssd_hist *h, double v);
+void    ssd_hist_merge(ssd_hist *to, ssd_hist *from);
+double  ssd_hist_mean(ssd_hist *h);
+double  ssd_hist_percentile(ssd_hist *h, double p);
+void    ssd_lat_stat_init(ssd_t *s);
+
+double  ssd_wall_time(void);
+double  ssd_prof_begin(ssd_t *s);
+void    ssd_prof_end(ssd_t *s, ssd_prof_entry_t entry, double start);
+
 void ssd_activate(ioreq_event *curr);
 double ssd_invoke_logblock_cleaning(int elem_num, ssd_t *s, int lbn);
 
@@ -537,6 +898,16 @@ int		ssd_logical_blockno(int blkno, ssd_t *s);
 void 	ssd_process_event(ioreq_event *curr);
 
 void	ssd_dpower(ssd_t *s, double cost);
+void	ssd_power_init(ssd_t *s);
+void	ssd_set_media_busy(ssd_t *s, ssd_element *elem, int busy);
+void	ssd_power_add_acc_time(double time, ssd_power_element_stat *power_stat, ssd_t *s);
+void	ssd_power_profile_init(ssd_t *s);
+void	ssd_power_profile_cpu(ssd_t *s, double start, double end);
+void	ssd_power_profile_dram(ssd_t *s, double start, double end);
+void	ssd_power_profile_settle(ssd_t *s, ssd_power_element_stat *power_stat, double time);
+void	ssd_power_profile_advance(ssd_t *s, double time);
+void	ssd_power_profile_finish(ssd_t *s);
+void	ssd_power_sampler_finish(ssd_t *s);
 
 #endif   /* DISKSIM_ssd_H */
 
@@ -0,0 +1,24 @@
+#ifndef DISKSIM_SSD_CHROME_TRACE_H
+#define DISKSIM_SSD_CHROME_TRACE_H
+
+#include "ssd.h"
+
+/*
+ * the flash operations, the cleanings and the channel transfers of an
+ * ssd are written as spans to ssd<devno>.trace.json, in the chrome
+ * trace event format (chrome://tracing, ui.perfetto.dev). each element
+ * has a track for its reads and writes and one for its cleanings, and
+ * each channel has a track for its transfers. only the spans that
+ * overlap the window set by the "Chrome trace start" and "Chrome trace
+ * end" parameters are written.
+ */
+typedef enum {
+	SSD_CHROME_ELEM,		// flash operations of an element
+	SSD_CHROME_GC,			// cleanings and merges of an element
+	SSD_CHROME_CHANNEL,		// transfers on a channel
+} ssd_chrome_track_t;
+
+void ssd_chrome_trace_init(ssd_t *s);
+void ssd_chrome_trace_span(ssd_t *s, ssd_chrome_track_t type, int num, char *name, double start, double end, int blkno);
+
+#endif
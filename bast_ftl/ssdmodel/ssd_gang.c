@@ -98,39 +98,21 @@ static void ssd_collect_req_in_gang
         tot_rd_reqs = 0;
         tot_wr_reqs = 0;
         if ((req = ioqueue_get_next_request(elem->queue)) != NULL) {
-            int found;
+            // only one request is taken from each element, so there is
+            // nothing collected yet that it could duplicate.
+            ssd_req *r = ssd_req_get(s);
+            r->blk = req->blkno;
+            r->count = req->bcount;
+            r->is_read = req->flags & READ;
+            r->org_req = req;
+            r->plane_num = -1; // we don't know to which plane this req will be directed at
 
             if (req->flags & READ) {
-                found = ssd_already_present(rd_q[j], tot_rd_reqs, req);
+                rd_q[j][tot_rd_reqs] = r;
+                tot_rd_reqs ++;
             } else {
-                found = ssd_already_present(wr_q[j], tot_wr_reqs, req);
-            }
-
-            if (!found) {
-                // this is a valid request
-                ssd_req *r = malloc(sizeof(ssd_req));
-                r->blk = req->blkno;
-                r->count = req->bcount;
-                r->is_read = req->flags & READ;
-                r->org_req = req;
-                r->plane_num = -1; // we don't know to which plane this req will be directed at
-
-                if (req->flags & READ) {
-                    rd_q[j][tot_rd_reqs] = r;
-                    tot_rd_reqs ++;
-                } else {
-                    wr_q[j][tot_wr_reqs] = r;
-                    tot_wr_reqs ++;
-                }
-            } else {
-                // throw this request -- it doesn't make sense
-                stat_update (&s->stat.acctimestats, 0);
-                req->time = simtime;
-                req->ssd_elem_num = i;
-                req->ssd_gang_num = gang_num;
-
-                req->type = DEVICE_ACCESS_COMPLETE;
-                addtointq ((event *)req);
+                wr_q[j][tot_wr_reqs] = r;
+                tot_wr_reqs ++;
             }
 
             ASSERT((tot_rd_reqs < MAX_REQS) && (tot_wr_reqs < MAX_REQS))
@@ -337,7 +319,7 @@ static void ssd_activate_gang_sync(int gang_num, ssd_t *s)
             }
 
             // we need to issue a new write request, so allocate
-            elem_req[0] = malloc(sizeof(ssd_req));
+            elem_req[0] = ssd_req_get(s);
             memset(elem_req[0], 0, sizeof(ssd_req));
 
             blk = start_pg * s->params.page_size;
@@ -394,8 +376,8 @@ static void ssd_activate_gang_sync(int gang_num, ssd_t *s)
             req->ssd_gang_num = gang_num;
             addtointq ((event *)req);
 
-            // free
-            free(elem_req[0]);
+            // release
+            ssd_req_put(s, elem_req[0]);
         }
 
         // we've processed one request from the queue
@@ -407,14 +389,13 @@ static void _ssd_activate_gang
 (ssd_t *s, gang_metadata *g, int gang_num, ssd_req ***reqs_queue, int read_flag, int total)
 {
     double after = 0;
-    ssd_req ***first;
+    ssd_req **first[SSD_MAX_ELEMS_PER_GANG];
     int i;
 
     if (total == 0) {
         return;
     }
 
-    first = (ssd_req ***) malloc (s->params.elements_per_gang * sizeof(ssd_req **));
     for (i = 0; i < s->params.elements_per_gang; i ++) {
         first[i] = &reqs_queue[i][0];
     }
@@ -437,7 +418,7 @@ static void _ssd_activate_gang
                 elem = &s->elements[elem_num];
 
                 g->busy = 1;
-                elem->media_busy = TRUE;
+                ssd_set_media_busy(s, elem, TRUE);
 
                 // issue just one req
                 ssd_compute_access_time(s, elem_num, reqs_queue[i], 1);
@@ -464,7 +445,7 @@ static void _ssd_activate_gang
 
                 // go to the next request in this element
                 reqs_queue[i] = &reqs_queue[i][1];
-                free(to_free);
+                ssd_req_put(s, to_free);
 
                 reqs_issued ++;
 
@@ -494,8 +475,6 @@ static void _ssd_activate_gang
     for (i = 0; i < s->params.elements_per_gang; i ++) {
         reqs_queue[i] = first[i];
     }
-
-    free(first);
 }
 
 /*
@@ -536,12 +515,10 @@ static void ssd_activate_gang(ssd_t *s, int gang_num)
             }
         }
 
-        // allocate
-        rd_q = (ssd_req ***) malloc(s->params.elements_per_gang * sizeof (ssd_req **));
-        wr_q = (ssd_req ***) malloc(s->params.elements_per_gang * sizeof (ssd_req **));
+        // the queues are preallocated with the gang
+        rd_q = g->rd_q;
+        wr_q = g->wr_q;
         for (i = 0; i < s->params.elements_per_gang; i ++) {
-            rd_q[i] = malloc(MAX_REQS * sizeof(ssd_req *));
-            wr_q[i] = malloc(MAX_REQS * sizeof(ssd_req *));
             memset(rd_q[i], 0, MAX_REQS * sizeof(ssd_req *));
             memset(wr_q[i], 0, MAX_REQS * sizeof(ssd_req *));
         }
@@ -554,14 +531,6 @@ static void ssd_activate_gang(ssd_t *s, int gang_num)
         _ssd_activate_gang(s, g, gang_num, wr_q, 0, wr_total);
 
         g->reqs_waiting -= (rd_total + wr_total);
-
-        // free
-        for (i = 0; i < s->params.elements_per_gang; i ++) {
-            free(rd_q[i]);
-            free(wr_q[i]);
-        }
-        free(rd_q);
-        free(wr_q);
     }
 }
 
@@ -768,7 +737,7 @@ void ssd_access_complete_gang (ioreq_event *curr)
 
    // all the reqs are over
    if (ioqueue_get_reqoutstanding(elem->queue) == 0) {
-    elem->media_busy = FALSE;
+    ssd_set_media_busy(currdisk, elem, FALSE);
    }
 
    some_elem_busy = 0;
@@ -9,6 +9,7 @@ typedef enum {
 	SSD_POWER_FLASH_ERASE,
 	SSD_POWER_FLASH_BUS_DATA_TRANSFER,
 	SSD_POWER_BUS_DATA_TRANSFER,
+	SSD_POWER_DRAM_ACCESS,
 	SSD_POWER_CPU_ACTIVE,
 	
 } ssd_power_type_t;
@@ -18,6 +19,7 @@ void ssd_power_ssd_calculate(ssd_power_type_t type, double time, ssd_t *s);
 void power_update(ssd_t *s, double cost);
 void print_power_start(ssd_t *s);
 void print_power_end(ssd_t *s);
+void ssd_power_profile_op(ssd_t *s, int elem_num, ssd_power_type_t type, double offset, double time);
 
 #endif
 
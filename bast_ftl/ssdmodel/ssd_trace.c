@@ -0,0 +1,234 @@
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ssd_trace.h"
+
+// number of records held by the ring of a trace. the writer thread
+// is woken up once half of the ring is filled.
+#define SSD_TRACE_RECORDS		(1 << 16)
+#define SSD_TRACE_WAKEUP		(SSD_TRACE_RECORDS / 2)
+
+struct _ssd_trace {
+	FILE *fp;
+	char *ring;
+	int record_size;
+	int head;				// next slot to fill
+	int tail;				// next slot to write out
+	int count;				// filled slots
+	int closing;
+	int threaded;
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	struct _ssd_trace *next;
+};
+
+// the open traces, written out at the end of the run
+static ssd_trace *traces = NULL;
+
+/*
+ * returns the number of records that can be written out of the
+ * ring in one piece, starting at the tail.
+ */
+static int ssd_trace_chunk(ssd_trace *t)
+{
+	int n = t->count;
+
+	if (t->tail + n > SSD_TRACE_RECORDS) {
+		n = SSD_TRACE_RECORDS - t->tail;
+	}
+	return n;
+}
+
+static void ssd_trace_write(ssd_trace *t, int n)
+{
+	fwrite(t->ring + (size_t)t->tail * t->record_size, t->record_size, n, t->fp);
+}
+
+static void ssd_trace_release(ssd_trace *t, int n)
+{
+	t->tail = (t->tail + n) % SSD_TRACE_RECORDS;
+	t->count -= n;
+}
+
+/*
+ * the writer thread drains the ring while the simulator keeps on
+ * appending records. the lock is not held during the fwrite since the
+ * simulator only fills the free slots of the ring.
+ */
+static void *ssd_trace_writer(void *arg)
+{
+	ssd_trace *t = (ssd_trace *)arg;
+	int n;
+
+	pthread_mutex_lock(&t->lock);
+	for (;;) {
+		while ((t->count < SSD_TRACE_WAKEUP) && (!t->closing)) {
+			pthread_cond_wait(&t->not_empty, &t->lock);
+		}
+		if (t->count == 0) {
+			break;
+		}
+
+		n = ssd_trace_chunk(t);
+		pthread_mutex_unlock(&t->lock);
+		ssd_trace_write(t, n);
+		pthread_mutex_lock(&t->lock);
+
+		ssd_trace_release(t, n);
+		pthread_cond_signal(&t->not_full);
+	}
+	pthread_mutex_unlock(&t->lock);
+
+	fflush(t->fp);
+	return NULL;
+}
+
+// writes out the whole ring from the calling thread.
+static void ssd_trace_drain(ssd_trace *t)
+{
+	int n;
+
+	if (t->count == 0) {
+		return;
+	}
+	while (t->count > 0) {
+		n = ssd_trace_chunk(t);
+		ssd_trace_write(t, n);
+		ssd_trace_release(t, n);
+	}
+	fflush(t->fp);
+}
+
+/*
+ * writes out the records left in the rings and stops the writers. the
+ * ssd calls it once it is done tracing, while the files are still open.
+ * the traces stay usable: a record appended later is written out by
+ * the simulator itself.
+ */
+void ssd_trace_flush_all(void)
+{
+	ssd_trace *t;
+
+	for (t = traces; t != NULL; t = t->next) {
+		if (t->threaded) {
+			pthread_mutex_lock(&t->lock);
+			t->closing = 1;
+			pthread_cond_signal(&t->not_empty);
+			pthread_mutex_unlock(&t->lock);
+			pthread_join(t->writer, NULL);
+			t->threaded = 0;
+		} else {
+			ssd_trace_drain(t);
+		}
+	}
+}
+
+/*
+ * registered with atexit when the first trace is opened, in case the
+ * run ends without the traces being flushed. only the records not yet
+ * written out touch the files.
+ */
+static void ssd_trace_close_all(void)
+{
+	ssd_trace *t;
+
+	ssd_trace_flush_all();
+	while ((t = traces) != NULL) {
+		traces = t->next;
+
+		pthread_mutex_destroy(&t->lock);
+		pthread_cond_destroy(&t->not_empty);
+		pthread_cond_destroy(&t->not_full);
+		free(t->ring);
+		free(t);
+	}
+}
+
+ssd_trace *ssd_trace_open(FILE *fp, const char *magic, int record_size)
+{
+	ssd_trace *t;
+
+	if ((t = (ssd_trace *)malloc(sizeof(ssd_trace))) == NULL) {
+		fprintf(stderr, "Error: malloc to trace in ssd_trace_open failed\n");
+		fprintf(stderr, "Allocation size = %d\n", (int)sizeof(ssd_trace));
+		exit(1);
+	}
+	if ((t->ring = (char *)malloc((size_t)SSD_TRACE_RECORDS * record_size)) == NULL) {
+		fprintf(stderr, "Error: malloc to t->ring in ssd_trace_open failed\n");
+		fprintf(stderr, "Allocation size = %d\n", SSD_TRACE_RECORDS * record_size);
+		exit(1);
+	}
+	t->fp = fp;
+	t->record_size = record_size;
+	t->head = t->tail = t->count = 0;
+	t->closing = 0;
+
+	// the file starts with the magic and the record size
+	fwrite(magic, 1, SSD_TRACE_MAGIC_LEN, fp);
+	fwrite(&record_size, sizeof(record_size), 1, fp);
+
+	pthread_mutex_init(&t->lock, NULL);
+	pthread_cond_init(&t->not_empty, NULL);
+	pthread_cond_init(&t->not_full, NULL);
+
+	// without a writer thread, the ring is written out
+	// by the simulator whenever it is full.
+	t->threaded = (pthread_create(&t->writer, NULL, ssd_trace_writer, t) == 0);
+	if (!t->threaded) {
+		fprintf(stderr, "Warning: cannot start the trace writer, writing synchronously\n");
+	}
+
+	if (traces == NULL) {
+		atexit(ssd_trace_close_all);
+	}
+	t->next = traces;
+	traces = t;
+
+	return t;
+}
+
+void ssd_trace_append(ssd_trace *t, const void *rec)
+{
+	if (!t->threaded) {
+		if (t->count == SSD_TRACE_RECORDS) {
+			ssd_trace_drain(t);
+		}
+	} else {
+		pthread_mutex_lock(&t->lock);
+		while (t->count == SSD_TRACE_RECORDS) {
+			pthread_cond_wait(&t->not_full, &t->lock);
+		}
+	}
+
+	memcpy(t->ring + (size_t)t->head * t->record_size, rec, t->record_size);
+	t->head = (t->head + 1) % SSD_TRACE_RECORDS;
+	t->count ++;
+
+	if (t->threaded) {
+		if (t->count == SSD_TRACE_WAKEUP) {
+			pthread_cond_signal(&t->not_empty);
+		}
+		pthread_mutex_unlock(&t->lock);
+	}
+}
+
+/*
+ * returns 1 if fp starts with the given magic and record size.
+ */
+int ssd_trace_read_header(FILE *fp, const char *magic, int record_size)
+{
+	char buf[SSD_TRACE_MAGIC_LEN];
+	int size;
+
+	if ((fread(buf, 1, SSD_TRACE_MAGIC_LEN, fp) != SSD_TRACE_MAGIC_LEN) ||
+		(memcmp(buf, magic, SSD_TRACE_MAGIC_LEN) != 0) ||
+		(fread(&size, sizeof(size), 1, fp) != 1) ||
+		(size != record_size)) {
+		return 0;
+	}
+	return 1;
+}
@@ -1,6 +1,9 @@
 // DiskSim SSD support
 // 2008 Microsoft Corporation. All Rights Reserved
 
+#include <math.h>
+#include <time.h>
+
 #include "ssd_utils.h"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -8,63 +11,207 @@
 //////////////////////////////////////////////////////////////////////////////
 
 
+#define SSD_WORD_BIT(pos)   (((ssd_bitmap_word)1) << ((pos) % SSD_BITS_PER_WORD))
+#define SSD_WORD_ALL_SET    (~((ssd_bitmap_word)0))
+
+//returns the position of the least significant set bit.
+//'w' must not be zero.
+static int ssd_word_ctz(ssd_bitmap_word w)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+
+    while (!(w & 0x1)) {
+        w >>= 1;
+        n ++;
+    }
+
+    return n;
+#endif
+}
+
+//returns the number of set bits in a word.
+static int ssd_word_popcount(ssd_bitmap_word w)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(w);
+#else
+    int n = 0;
+
+    while (w) {
+        w &= (w - 1);
+        n ++;
+    }
+
+    return n;
+#endif
+}
+
+//allocates a bitmap of 'total' bits, all cleared.
+//the unused bits of the last word are kept set so that
+//the searches never return them.
+ssd_bitmap *ssd_bitmap_alloc(int total)
+{
+    int i;
+    int nwords = SSD_BITMAP_WORDS(total);
+    int nfull = SSD_BITMAP_WORDS(nwords);
+    ssd_bitmap *c;
+
+    if (!(c = (ssd_bitmap *)malloc(sizeof(ssd_bitmap))) ||
+        !(c->words = (ssd_bitmap_word *)malloc(nwords * sizeof(ssd_bitmap_word))) ||
+        !(c->full = (ssd_bitmap_word *)malloc(nfull * sizeof(ssd_bitmap_word)))) {
+        fprintf(stderr, "Error: malloc to bitmap in ssd_bitmap_alloc failed\n");
+        fprintf(stderr, "Allocation size = %d\n", (nwords + nfull) * sizeof(ssd_bitmap_word));
+        exit(1);
+    }
+
+    c->total = total;
+    memset(c->words, 0, nwords * sizeof(ssd_bitmap_word));
+    memset(c->full, 0, nfull * sizeof(ssd_bitmap_word));
+
+    for (i = total; i < nwords * SSD_BITS_PER_WORD; i ++) {
+        ssd_set_bit(c, i);
+    }
+    for (i = nwords; i < nfull * SSD_BITS_PER_WORD; i ++) {
+        c->full[i / SSD_BITS_PER_WORD] |= SSD_WORD_BIT(i);
+    }
+
+    return c;
+}
+
 //clears a particular bit.
-//pos 0 corresponds to msb
-void ssd_clear_bit(unsigned char *c, int pos)
+void ssd_clear_bit(ssd_bitmap *c, int pos)
 {
-    int byte = pos / 8;
-    int bit_pos = 7 - (pos % 8);
+    int word = pos / SSD_BITS_PER_WORD;
 
-    c[byte] = (c[byte] & (~(0x1 << bit_pos)));
+    c->words[word] &= ~SSD_WORD_BIT(pos);
+    c->full[word / SSD_BITS_PER_WORD] &= ~SSD_WORD_BIT(word);
 
     return;
 }
 
-
 //sets a particular bit.
-//pos 0 corresponds to msb and pos 7 corresponds
-//to lsb.
-void ssd_set_bit(unsigned char *c, int pos)
+void ssd_set_bit(ssd_bitmap *c, int pos)
 {
-    int byte = pos / 8;
-    int bit_pos = 7 - (pos % 8);
+    int word = pos / SSD_BITS_PER_WORD;
 
-    c[byte] = (c[byte] | (0x1 << bit_pos));
+    c->words[word] |= SSD_WORD_BIT(pos);
+    if (c->words[word] == SSD_WORD_ALL_SET) {
+        c->full[word / SSD_BITS_PER_WORD] |= SSD_WORD_BIT(word);
+    }
 
     return;
 }
 
 //returns true if a bit is set
-int ssd_bit_on(unsigned char *c, int pos)
+int ssd_bit_on(ssd_bitmap *c, int pos)
 {
-    int byte = pos / 8;
-    int bit_pos = 7 - (pos % 8);
+    return ((c->words[pos / SSD_BITS_PER_WORD] & SSD_WORD_BIT(pos)) != 0);
+}
+
+//returns the first word at or after 'word' that has a zero bit,
+//or -1 if there is none up to 'last_word'.
+static int ssd_next_free_word(ssd_bitmap *c, int word, int last_word)
+{
+    int i;
+    ssd_bitmap_word w;
+
+    // the caller may step one past the last word
+    if (word > last_word) {
+        return -1;
+    }
+
+    i = word / SSD_BITS_PER_WORD;
+    w = ~c->full[i] & (SSD_WORD_ALL_SET << (word % SSD_BITS_PER_WORD));
+
+    while (!w) {
+        i ++;
+        if (i * SSD_BITS_PER_WORD > last_word) {
+            return -1;
+        }
+        w = ~c->full[i];
+    }
 
-    return (c[byte] & (0x1 << bit_pos));
+    word = i * SSD_BITS_PER_WORD + ssd_word_ctz(w);
+    return ((word <= last_word) ? word : -1);
+}
+
+//finds the first zero bit in the positions [first, last).
+//returns -1 if all of them are set.
+static int _ssd_find_zero_bit(ssd_bitmap *c, int first, int last)
+{
+    int word;
+    int last_word;
+    ssd_bitmap_word w;
+
+    if (first >= last) {
+        return -1;
+    }
+
+    word = first / SSD_BITS_PER_WORD;
+    last_word = (last - 1) / SSD_BITS_PER_WORD;
+    w = ~c->words[word] & (SSD_WORD_ALL_SET << (first % SSD_BITS_PER_WORD));
+
+    while (!w) {
+        if ((word = ssd_next_free_word(c, word + 1, last_word)) == -1) {
+            return -1;
+        }
+        w = ~c->words[word];
+    }
+
+    first = word * SSD_BITS_PER_WORD + ssd_word_ctz(w);
+    return ((first < last) ? first : -1);
 }
 
 //finds the position of the first zero-th
-//bit in an unsigned char array. the positions are
-//numbered starting from 0 from msb to lsb. returns -1
+//bit in the bitmap. returns -1
 //if all the bits are already set. 'total' specifies the
 //number of bits to consider in the array. 'start' gives
 //the location from which to start the search.
-int ssd_find_zero_bit(unsigned char *c, int total, int start)
+int ssd_find_zero_bit(ssd_bitmap *c, int total, int start)
 {
-    int bit = start;
-    int temp = total;
+    return ssd_find_zero_bit_in_range(c, 0, total, start);
+}
 
-    while (temp) {
-        int byte = bit / 8;
-        if ((c[byte] >> (7 - (bit % 8))) & 0x1) {
-            bit = (bit + 1) % total;
-            temp --;
-        } else {
-            return bit;
+//same as above, but considers only the bits in
+//[first, last). the search starts at 'start' and
+//wraps around to 'first'.
+int ssd_find_zero_bit_in_range(ssd_bitmap *c, int first, int last, int start)
+{
+    int bit;
+
+    ASSERT((start >= first) && (start < last));
+
+    if ((bit = _ssd_find_zero_bit(c, start, last)) == -1) {
+        bit = _ssd_find_zero_bit(c, first, start);
+    }
+
+    return bit;
+}
+
+//returns the number of zero bits in [first, last).
+int ssd_count_zero_bits(ssd_bitmap *c, int first, int last)
+{
+    int count = 0;
+
+    while (first < last) {
+        int word = first / SSD_BITS_PER_WORD;
+        int offset = first % SSD_BITS_PER_WORD;
+        int nbits = SSD_BITS_PER_WORD - offset;
+        ssd_bitmap_word w = ~c->words[word] >> offset;
+
+        if (nbits > last - first) {
+            nbits = last - first;
+            w &= (SSD_WORD_BIT(nbits) - 1);
         }
+
+        count += ssd_word_popcount(w);
+        first += nbits;
     }
 
-    return -1;
+    return count;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -304,3 +451,176 @@ listnode *ll_get_nth_node(listnode *start, int n)
     fprintf(stderr, "Error: cannot find the %d node in list\n", n);
     return NULL;
 }
+
+//////////////////////////////////////////////////////////////////////////////
+//                 code for the latency histograms
+//////////////////////////////////////////////////////////////////////////////
+
+static int ssd_hist_bucket(double v)
+{
+    double units = v / SSD_HIST_UNIT;
+    long long x;
+    int e;
+
+    if (units < SSD_HIST_SUB_BUCKETS) {
+        return (units > 0) ? (int)units : 0;
+    }
+    if (units >= (double)(1LL << SSD_HIST_MAX_BITS)) {
+        return SSD_HIST_BUCKETS - 1;
+    }
+
+    // e is the position of the most significant bit of x. the next
+    // SSD_HIST_SUB_BITS bits select the bucket within this power of two.
+    x = (long long)units;
+    frexp((double)x, &e);
+    e --;
+
+    return (e - SSD_HIST_SUB_BITS + 1) * SSD_HIST_SUB_BUCKETS +
+           (int)(x >> (e - SSD_HIST_SUB_BITS)) - SSD_HIST_SUB_BUCKETS;
+}
+
+// returns the largest time that falls in bucket b.
+static double ssd_hist_bucket_top(int b)
+{
+    int shift;
+    long long top;
+
+    if (b < SSD_HIST_SUB_BUCKETS) {
+        return (b + 1) * SSD_HIST_UNIT;
+    }
+
+    shift = b / SSD_HIST_SUB_BUCKETS - 1;
+    top = (long long)(b % SSD_HIST_SUB_BUCKETS + SSD_HIST_SUB_BUCKETS + 1) << shift;
+    return top * SSD_HIST_UNIT;
+}
+
+void ssd_hist_add(ssd_hist *h, double v)
+{
+    h->buckets[ssd_hist_bucket(v)] ++;
+    h->count ++;
+    h->sum += v;
+    if (h->max < v) {
+        h->max = v;
+    }
+}
+
+void ssd_hist_merge(ssd_hist *to, ssd_hist *from)
+{
+    int i;
+
+    for (i = 0; i < SSD_HIST_BUCKETS; i ++) {
+        to->buckets[i] += from->buckets[i];
+    }
+    to->count += from->count;
+    to->sum += from->sum;
+    if (to->max < from->max) {
+        to->max = from->max;
+    }
+}
+
+double ssd_hist_mean(ssd_hist *h)
+{
+    if (h->count == 0) {
+        return 0;
+    }
+    return h->sum / h->count;
+}
+
+/*
+ * returns the time below which a fraction p (0 < p <= 1) of the
+ * recorded times fall.
+ */
+double ssd_hist_percentile(ssd_hist *h, double p)
+{
+    long long target;
+    long long seen = 0;
+    double top;
+    int i;
+
+    if (h->count == 0) {
+        return 0;
+    }
+
+    target = (long long)(p * h->count);
+    if (target < p * h->count) {
+        target ++;
+    }
+    if (target < 1) {
+        target = 1;
+    }
+
+    for (i = 0; i < SSD_HIST_BUCKETS; i ++) {
+        seen += h->buckets[i];
+        if (seen >= target) {
+            // the last bucket also holds the times beyond the range
+            top = ssd_hist_bucket_top(i);
+            if ((i == SSD_HIST_BUCKETS - 1) || (top > h->max)) {
+                return h->max;
+            }
+            return top;
+        }
+    }
+
+    return h->max;
+}
+
+/*
+ * the histograms of the elements are allocated here rather than kept in
+ * the element structures, which are part of every ssd slot.
+ */
+void ssd_lat_stat_init(ssd_t *s)
+{
+    int i;
+
+    for (i = 0; i < s->params.nelements; i ++) {
+        ssd_element *elem = &s->elements[i];
+
+        if (elem->lat == NULL) {
+            if (!(elem->lat = (ssd_lat_stat *)malloc(sizeof(ssd_lat_stat)))) {
+                fprintf(stderr, "Error: malloc to elem->lat in ssd_lat_stat_init failed\n");
+                fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_lat_stat));
+                exit(1);
+            }
+        }
+        memset(elem->lat, 0, sizeof(ssd_lat_stat));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//                 code for the self profiling
+//////////////////////////////////////////////////////////////////////////////
+
+// returns the wall clock time in seconds
+double ssd_wall_time(void)
+{
+#ifdef WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+ * the time returned by ssd_prof_begin is handed back to ssd_prof_end
+ * when the event or call is over. the clock is not read at all if the
+ * profiling is off.
+ */
+double ssd_prof_begin(ssd_t *s)
+{
+    if (!s->params.self_profiling) {
+        return 0;
+    }
+    return ssd_wall_time();
+}
+
+void ssd_prof_end(ssd_t *s, ssd_prof_entry_t entry, double start)
+{
+    if (!s->params.self_profiling) {
+        return;
+    }
+    s->prof.count[entry] ++;
+    s->prof.wall[entry] += ssd_wall_time() - start;
+}
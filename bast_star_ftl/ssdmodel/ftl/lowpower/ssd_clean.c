@@ -57,9 +57,17 @@ static double ssd_crossover_cost
  */
 void ssd_update_block_lifetime(double time, int blk, ssd_element_metadata *metadata)
 {
+    long long erasures = SSD_MAX_ERASURES - metadata->block_usage[blk].rem_lifetime;
+
     metadata->block_usage[blk].rem_lifetime --;
     metadata->block_usage[blk].time_of_last_erasure = time;
 
+    // update the running wear statistics. the square of the
+    // block's erasure count grows from e^2 to (e+1)^2.
+    metadata->plane_meta[metadata->block_usage[blk].plane_num].tot_erasures ++;
+    metadata->tot_erasures ++;
+    metadata->tot_erasures_sqr += 2 * erasures + 1;
+
     if (metadata->block_usage[blk].rem_lifetime < 0) {
         fprintf(stderr, "Error: Negative lifetime %d (block is being erased after it's dead)\n",
             metadata->block_usage[blk].rem_lifetime);
@@ -135,22 +143,14 @@ int ssd_rate_limit(int block_life, double avg_lifetime)
 
 /*
  * computes the average lifetime of all the blocks in a plane.
+ * the average remaining life time is the max num of erasures less
+ * the average num of erasures performed on the blocks so far.
  */
 double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
 {
-    int i;
-    int bitpos;
-    double tot_lifetime = 0;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    bitpos = plane_num * s->params.blocks_per_plane;
-    for (i = bitpos; i < bitpos + (int)s->params.blocks_per_plane; i ++) {
-        int block = ssd_bitpos_to_block(i, s);
-        ASSERT(metadata->block_usage[block].plane_num == plane_num);
-        tot_lifetime += metadata->block_usage[block].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_plane);
+    return (SSD_MAX_ERASURES - ((double)metadata->plane_meta[plane_num].tot_erasures / s->params.blocks_per_plane));
 }
 
 
@@ -159,15 +159,9 @@ double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
  */
 double ssd_compute_avg_lifetime_in_element(int elem_num, ssd_t *s)
 {
-    double tot_lifetime = 0;
-    int i;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        tot_lifetime += metadata->block_usage[i].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_element);
+    return (SSD_MAX_ERASURES - ((double)metadata->tot_erasures / s->params.blocks_per_element));
 }
 
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s)
@@ -248,32 +242,6 @@ int ssd_pick_wear_aware(int blk, int block_life, double avg_lifetime, ssd_t *s)
 }
 #endif
 
-static int _ssd_pick_block_to_clean
-(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
-{
-    int block_life;
-
-    if (plane_num != -1) {
-        if (metadata->block_usage[blk].plane_num != plane_num) {
-            return 0;
-        }
-    }
-
-    block_life = metadata->block_usage[blk].rem_lifetime;
-
-    // if the block is already dead, skip it
-    if (block_life == 0) {
-        return 0;
-    }
-
-    // clean only those blocks that are sealed.
-    /*if (!ssd_can_clean_block(s, metadata, blk)) {
-        return 0;
-    }*/
-
-    return 1;
-}
-
 /*
  * migrate data from a cold block to "to_blk"
  */
@@ -432,139 +400,97 @@ int ssd_pick_wear_aware_with_migration
 }
 
 /*
- * a greedy solution, where we find the block in a plane with the least
- * num of valid pages and return it.
+ * log usage table: every log block in use is linked on the list matching
+ * the num of valid pages in its data block and itself (the pages a full
+ * merge has to copy). the lists are updated whenever a page is written
+ * to the data or the log block, and when the log block is merged.
  */
-static int ssd_pick_block_to_clean2(int plane_num, int elem_num, double *mcost, ssd_element_metadata *metadata, ssd_t *s)
+static void ssd_log_usage_unlink(int log_index, ssd_element_metadata *metadata)
 {
-    double avg_lifetime = 1;
-    int i;
-    int size;
-    int block = -1;
-    int min_valid = s->params.pages_per_block - 1; // one page goes for the summary info
-    listnode *greedy_list;
-
-    *mcost = 0;
-
-    // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    // we create a list of greedily selected blocks
-    ll_create(&greedy_list);
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-
-            // greedily select the block
-            if (metadata->block_usage[i].num_valid <= min_valid) {
-                ASSERT(i == metadata->block_usage[i].block_num);
-                ll_insert_at_head(greedy_list, (void*)&metadata->block_usage[i]);
-                min_valid = metadata->block_usage[i].num_valid;
-                block = i;
-            }
-        }
-    }
+	log_table *log = &metadata->log_data[log_index];
 
-    ASSERT(block != -1);
-    block = -1;
+	if (log->usage_prev != -1) {
+		metadata->log_data[log->usage_prev].usage_next = log->usage_next;
+	} else {
+		ASSERT(metadata->log_usage[log->usage] == log_index);
+		metadata->log_usage[log->usage] = log->usage_next;
+	}
 
-    // from the greedily picked blocks, select one after rate
-    // limiting the overly used blocks
-    size = ll_get_size(greedy_list);
+	if (log->usage_next != -1) {
+		metadata->log_data[log->usage_next].usage_prev = log->usage_prev;
+	}
 
-    //printf("plane %d elem %d size %d avg lifetime %f\n",
-    //  plane_num, elem_num, size, avg_lifetime);
+	log->usage = -1;
+	log->usage_prev = -1;
+	log->usage_next = -1;
+}
 
-    for (i = 0; i < size; i ++) {
-        block_metadata *bm;
-        int mig_blk;
+/*
+ * removes a log block from the log usage table (when it is merged).
+ */
+void ssd_log_usage_remove(int log_index, ssd_element_metadata *metadata)
+{
+	if (metadata->log_data[log_index].usage != -1) {
+		ssd_log_usage_unlink(log_index, metadata);
+	}
+}
 
-        listnode *n = ll_get_nth_node(greedy_list, i);
-        bm = ((block_metadata *)n->data);
+/*
+ * moves a log block to the list matching its current usage.
+ */
+void ssd_log_usage_update(int log_index, ssd_element_metadata *metadata, ssd_t *s)
+{
+	log_table *log = &metadata->log_data[log_index];
+	int usage;
 
-        if (i == 0) {
-            ASSERT(min_valid == bm->num_valid);
-        }
+	if (log->bsn == -1) {
+		ssd_log_usage_remove(log_index, metadata);
+		return;
+	}
 
-        // this is the last of the greedily picked blocks.
-        if (i == size -1) {
-            // select it!
-            block = bm->block_num;
-            break;
-        }
+	ASSERT(log->lbn != -1);
+	usage = metadata->block_usage[metadata->lba_table[log->lbn]].num_valid + metadata->block_usage[log->bsn].num_valid;
+	ASSERT(usage <= 2 * s->params.pages_per_block);
 
-        if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
-            block = bm->block_num;
-            break;
-        } else {
-#if MIGRATE
-            // migration
-            mig_blk = ssd_pick_wear_aware_with_migration(bm->block_num, bm->rem_lifetime, avg_lifetime, mcost, bm->plane_num, elem_num, s);
-            if (mig_blk != bm->block_num) {
-                // data has been migrated and we have a new
-                // block to use
-                block = mig_blk;
-                break;
-            }
-#endif
+	if (log->usage == usage) {
+		return;
+	}
 
-            // pick this block giving consideration to its life time
-            if (ssd_pick_wear_aware(bm->block_num, bm->rem_lifetime, avg_lifetime, s)) {
-                block = bm->block_num;
-                break;
-            }
-        }
-    }
+	ssd_log_usage_remove(log_index, metadata);
 
-    ll_release(greedy_list);
+	log->usage = usage;
+	log->usage_prev = -1;
+	log->usage_next = metadata->log_usage[usage];
+	if (log->usage_next != -1) {
+		metadata->log_data[log->usage_next].usage_prev = log_index;
+	}
+	metadata->log_usage[usage] = log_index;
 
-    ASSERT(block != -1);
-    return block;
+	if (usage < metadata->log_usage_min) {
+		metadata->log_usage_min = usage;
+	}
 }
 
+/*
+ * picks the logical block whose data and log blocks together have the
+ * least num of valid pages.
+ */
 static int ssd_pick_block_to_clean(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
-	int block;
-	int log_block;
-	int lbn;
-	int min_valid = s->params.pages_per_block * 2;
-	int i,j;
-	double avg_lifetime = 1;
-	unsigned int reserved_blocks_per_plane = (s->params.reserve_blocks * s->params.blocks_per_plane) / 100;
-    unsigned int usable_blocks_per_plane = s->params.blocks_per_plane - reserved_blocks_per_plane;
-    unsigned int reserved_blocks = reserved_blocks_per_plane * s->params.planes_per_pkg;
-    unsigned int usable_blocks = usable_blocks_per_plane * s->params.planes_per_pkg;
-	int num_valid;
-
-	avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
+	int max_usage = s->params.pages_per_block * 2;
 
-	for(i = 0; i < usable_blocks ; i++) {
-		block = metadata->lba_table[i];
-		if(block == -1){
-			continue;
-		}
-		if( metadata->block_usage[block].log_index == -1){
-			continue;
-		}
+	// skip over the lists that have been emptied since
+	while ((metadata->log_usage_min <= max_usage) && (metadata->log_usage[metadata->log_usage_min] == -1)) {
+		metadata->log_usage_min++;
+	}
 
-		log_block = metadata->log_data[metadata->block_usage[block].log_index].bsn;
-		num_valid = metadata->block_usage[block].num_valid + metadata->block_usage[log_block].num_valid;
-		if(num_valid < min_valid) {
-			/*min_valid = metadata->block_usage[block].num_valid;
-			if(_ssd_pick_block_to_clean(block, plane_num, elem_num, metadata, s)){
-				int mig_blk;
-				block_metadata bm;
-				bm = metadata->block_usage[block];
-				mig_blk = ssd_pick_wear_aware_with_migration(bm.block_num, bm.rem_lifetime, avg_lifetime, mcost, bm.plane_num, elem_num, s);
-				if (ssd_pick_wear_aware(bm.block_num, bm.rem_lifetime, avg_lifetime, s)) {
-					lbn = i;
-					break;
-				}
-			}*/
-			lbn = i;
-		}
+	if (metadata->log_usage_min > max_usage) {
+		fprintf(outputfile3, "Error: we cannot find a log block to clean in elem %d\n", elem_num);
+		ASSERT(0);
+		exit(1);
 	}
 
-    return lbn;
+	return metadata->log_data[metadata->log_usage[metadata->log_usage_min]].lbn;
 }
 
 double _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
@@ -593,214 +519,6 @@ double _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_
     return cost;
 }
 
-static usage_table *ssd_build_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        int usage = metadata->block_usage[i].num_valid;
-        table[usage].len ++;
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        usage_table *entry;
-        int usage = metadata->block_usage[i].num_valid;
-
-        entry = &(table[usage]);
-        entry->block[entry->temp ++] = i;
-    }
-
-    return table;
-}
-
-static void ssd_release_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
-static usage_table *ssd_build_log_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-	int reserved_blocks_per_plane = (s->params.reserve_blocks * s->params.blocks_per_plane) / 100;
-	int reserved_blocks = reserved_blocks_per_plane * s->params.planes_per_pkg;  
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < reserved_blocks; i ++) {
-		int usage;
-		int block;
-		if(metadata->log_data[i].bsn != -1){
-			block = metadata->log_data[i].bsn;
-			usage = metadata->block_usage[block].num_valid;
-			table[usage].len ++;
-		}
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < reserved_blocks; i ++) {
-        usage_table *entry;
-        int usage;
-		int block;
-		if(metadata->log_data[i].bsn != -1){
-			block = metadata->log_data[i].bsn;
-			usage = metadata->block_usage[block].num_valid;
-			entry = &(table[usage]);
-			entry->block[entry->temp ++] = block;
-		}
-    }
-
-    return table;
-}
-
-static void ssd_release_log_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
-#define GREEDY_IN_COPYBACK 0
-
-/*
- * first we create a hash table of blocks according to their
- * usage. then we select blocks with the least usage and clean
- * them.
- */
-static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
-{
-    double cost = 0;
-    double avg_lifetime;
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    /////////////////////////////////////////////////////////////////////////////
-    // build the histogram
-    table = ssd_build_usage_table(elem_num, s);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    /////////////////////////////////////////////////////////////////////////////
-    // we now have a hash table of blocks, where the key of each
-    // bucket is the usage count and each bucket has all the blocks with
-    // the same usage count (i.e., the same num of valid pages).
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        int j;
-        usage_table *entry;
-
-        // get the bucket of blocks with 'i' valid pages
-        entry = &(table[i]);
-
-        // free all the blocks with 'i' valid pages
-        for (j = 0; j < entry->len; j ++) {
-            int blk = entry->block[j];
-            int block_life = metadata->block_usage[blk].rem_lifetime;
-
-            // if this is plane specific cleaning, then skip all the
-            // blocks that don't belong to this plane.
-            if ((plane_num != -1) && (metadata->block_usage[blk].plane_num != plane_num)) {
-                continue;
-            }
-
-            // if the block is already dead, skip it
-            if (block_life == 0) {
-                continue;
-            }
-
-            // clean only those blocks that are sealed.
-            if (ssd_can_clean_block(s, metadata, blk)) {
-
-                // if we care about wear-leveling, then we must rate limit overly cleaned blocks
-                if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
-
-                    // see if this block's remaining lifetime is within
-                    // a certain threshold of the average remaining lifetime
-                    // of all blocks in this element
-                    if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
-                        // we have to rate limit this block as it has exceeded
-                        // its cleaning limits
-                        printf("Rate limiting block %d (block life %d avg life %f\n",
-                            blk, block_life, avg_lifetime);
-
-                        if (ssd_rate_limit(block_life, avg_lifetime)) {
-                            // skip this block and go to the next one
-                            continue;
-                        }
-                    }
-                }
-
-                // okies, finally here we're with the block to be cleaned.
-                // invoke cleaning until we reach the high watermark.
-                cost += _ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
-
-                if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-                    // no more cleaning is required -- so quit.
-                    break;
-                }
-            }
-        }
-
-        if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-            // no more cleaning is required -- so quit.
-            break;
-        }
-    }
-
-    // release the table
-    ssd_release_usage_table(table, s);
-
-    // see if we were able to generate enough free blocks
-    if (!ssd_stop_cleaning(plane_num, elem_num, s)) {
-        printf("Yuck! we couldn't generate enough free pages in plane %d elem %d ssd %d\n",
-            plane_num, elem_num, s->devno);
-    }
-
-    return cost;
-}
-
 /*
  * 1. find a plane to clean in each of the parallel unit
  * 2. invoke copyback cleaning on all such planes simultaneously
@@ -846,6 +564,7 @@ double ssd_fullmerge(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element
 
 	//update stat
 	//update log_table
+	ssd_log_usage_remove(log_index, metadata);
 	metadata->block_usage[prev_block].log_index = -1;
 	metadata->log_data[log_index].bsn = -1;
 	metadata->log_data[log_index].data_block = -1;
@@ -941,6 +660,7 @@ double ssd_switch(ssd_t *s, ssd_element_metadata *metadata, ssd_power_element_st
 	metadata->lba_table[lbn] = log_block;
 
 	//update stat
+	ssd_log_usage_remove(log_index, metadata);
 	metadata->block_usage[d_block].log_index = -1;
 	metadata->log_data[log_index].bsn = -1;
 	metadata->log_data[log_index].data_block = -1;
@@ -1062,6 +782,7 @@ double ssd_replacement(ssd_t *s, int elem_num, int lbn)
 		metadata->block_usage[prev_log_block].page[i] = -1;
 	}
 	metadata->block_usage[prev_log_block].num_valid = 0;
+	ssd_log_usage_update(log_index, metadata, s);
 
 	//plane metadata update
 	metadata->plane_meta[prev_plane_num].valid_pages -= num_valid;
@@ -0,0 +1,337 @@
+
+#include "ssd.h"
+#include "ssd_cache.h"
+#include "ssd_power.h"
+
+void ssd_cache_init(ssd_t *s)
+{
+	ssd_cache *c = s->cache;
+	int page_bytes = s->params.page_size * SSD_DATA_BYTES_PER_SECTOR;
+	int num_pages = s->params.dram_cache_size / page_bytes;
+	int batch;
+	int i;
+
+	if ((s->params.buffer_cache_policy == SSD_BUFFER_CACHE_NO_USE) || (num_pages <= 0)) {
+		s->cache = NULL;
+		return;
+	}
+
+	// the gangs do not go through the buffer cache
+	if (s->params.alloc_pool_logic == SSD_ALLOC_POOL_GANG) {
+		fprintf(stderr, "Warning: the buffer cache is not used with the gang allocation pool\n");
+		s->cache = NULL;
+		return;
+	}
+
+	batch = s->params.dram_destage_batch;
+	if (batch < 1) {
+		batch = 1;
+	} else if (batch > num_pages) {
+		batch = num_pages;
+	}
+
+	if (c == NULL) {
+		if ((c = (ssd_cache *)malloc(sizeof(ssd_cache))) == NULL) {
+			fprintf(stderr, "Error: malloc to cache in ssd_cache_init failed\n");
+			fprintf(stderr, "Allocation size = %d\n", (int)sizeof(ssd_cache));
+			exit(1);
+		}
+		c->num_pages = num_pages;
+		c->batch = batch;
+		if ((c->pages = (ssd_cache_page *)malloc(num_pages * sizeof(ssd_cache_page))) == NULL) {
+			fprintf(stderr, "Error: malloc to c->pages in ssd_cache_init failed\n");
+			fprintf(stderr, "Allocation size = %d\n", num_pages * (int)sizeof(ssd_cache_page));
+			exit(1);
+		}
+		if ((c->hash = (ssd_cache_page **)malloc(num_pages * sizeof(ssd_cache_page *))) == NULL) {
+			fprintf(stderr, "Error: malloc to c->hash in ssd_cache_init failed\n");
+			fprintf(stderr, "Allocation size = %d\n", num_pages * (int)sizeof(ssd_cache_page *));
+			exit(1);
+		}
+		if ((c->destage = (int *)malloc(batch * sizeof(int))) == NULL) {
+			fprintf(stderr, "Error: malloc to c->destage in ssd_cache_init failed\n");
+			fprintf(stderr, "Allocation size = %d\n", batch * (int)sizeof(int));
+			exit(1);
+		}
+		s->cache = c;
+	}
+
+	// the buffer starts empty
+	c->window = (int)(s->params.dram_cache_window * num_pages);
+	c->free = NULL;
+	for (i = num_pages - 1; i >= 0; i --) {
+		c->pages[i].hnext = c->free;
+		c->free = &c->pages[i];
+	}
+	memset(c->hash, 0, num_pages * sizeof(ssd_cache_page *));
+	c->mru = c->lru = NULL;
+	c->busy_until = 0;
+
+	for (i = 0; i < SSD_CACHE_STREAMS; i ++) {
+		c->stream_next[i] = -1;
+		c->stream_end[i] = -1;
+	}
+	c->stream_victim = 0;
+}
+
+static ssd_cache_page *ssd_cache_lookup(ssd_cache *c, int lpn)
+{
+	ssd_cache_page *p;
+
+	for (p = c->hash[lpn % c->num_pages]; p != NULL; p = p->hnext) {
+		if (p->lpn == lpn) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static void ssd_cache_unlink(ssd_cache *c, ssd_cache_page *p)
+{
+	if (p->prev != NULL) {
+		p->prev->next = p->next;
+	} else {
+		c->mru = p->next;
+	}
+	if (p->next != NULL) {
+		p->next->prev = p->prev;
+	} else {
+		c->lru = p->prev;
+	}
+}
+
+static void ssd_cache_push_mru(ssd_cache *c, ssd_cache_page *p)
+{
+	p->prev = NULL;
+	p->next = c->mru;
+	if (c->mru != NULL) {
+		c->mru->prev = p;
+	} else {
+		c->lru = p;
+	}
+	c->mru = p;
+}
+
+static void ssd_cache_remove(ssd_t *s, ssd_cache *c, ssd_cache_page *p)
+{
+	ssd_cache_page **h = &c->hash[p->lpn % c->num_pages];
+
+	if (p->prefetched) {
+		s->stat.cache_prefetch_wasted ++;
+	}
+
+	while (*h != p) {
+		h = &(*h)->hnext;
+	}
+	*h = p->hnext;
+
+	ssd_cache_unlink(c, p);
+	p->hnext = c->free;
+	c->free = p;
+}
+
+static int ssd_cache_lpn_compare(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+ * makes room for a page. returns the number of dirty pages to destage,
+ * in ascending order of lpn, in c->destage.
+ */
+static int ssd_cache_evict(ssd_t *s, ssd_cache *c)
+{
+	ssd_cache_page *victim = c->lru;
+	ssd_cache_page *p;
+	int n = 0;
+	int i;
+
+	if (s->params.buffer_cache_policy == SSD_BUFFER_CACHE_CFLRU) {
+		for (p = c->lru, i = 0; (p != NULL) && (i < c->window); p = p->prev, i ++) {
+			if (!p->dirty) {
+				victim = p;
+				break;
+			}
+		}
+	}
+
+	// the victim goes out with the dirty pages next to it at the lru
+	// end. the other pages of the batch stay in the buffer, clean.
+	if (victim->dirty) {
+		for (p = victim; (p != NULL) && (n < c->batch); p = p->prev) {
+			if (p->dirty) {
+				c->destage[n ++] = p->lpn;
+				p->dirty = 0;
+			}
+		}
+		qsort(c->destage, n, sizeof(int), ssd_cache_lpn_compare);
+
+		s->stat.cache_destages ++;
+		s->stat.cache_pages_destaged += n;
+	}
+
+	ssd_cache_remove(s, c, victim);
+	return n;
+}
+
+// returns 1 if the page is in the buffer
+int ssd_cache_holds(ssd_t *s, int lpn)
+{
+	return (ssd_cache_lookup(s->cache, lpn) != NULL);
+}
+
+// returns 1 if the page is in the buffer, and counts the hit or miss
+int ssd_cache_read(ssd_t *s, int lpn)
+{
+	ssd_cache *c = s->cache;
+	ssd_cache_page *p = ssd_cache_lookup(c, lpn);
+
+	if (p == NULL) {
+		s->stat.cache_read_misses ++;
+		return 0;
+	}
+
+	if (p->prefetched) {
+		s->stat.cache_prefetch_hits ++;
+		p->prefetched = 0;
+	}
+
+	ssd_cache_unlink(c, p);
+	ssd_cache_push_mru(c, p);
+	s->stat.cache_read_hits ++;
+	return 1;
+}
+
+/*
+ * writes a page to the buffer. returns the number of dirty pages that
+ * were destaged to make room for it, whose lpns are in *destage.
+ */
+int ssd_cache_write(ssd_t *s, int lpn, int **destage)
+{
+	ssd_cache *c = s->cache;
+	ssd_cache_page *p = ssd_cache_lookup(c, lpn);
+	int n = 0;
+
+	*destage = c->destage;
+
+	if (p != NULL) {
+		s->stat.cache_write_hits ++;
+		if (p->prefetched) {
+			s->stat.cache_prefetch_wasted ++;
+			p->prefetched = 0;
+		}
+		ssd_cache_unlink(c, p);
+	} else {
+		s->stat.cache_write_misses ++;
+		if (c->free == NULL) {
+			n = ssd_cache_evict(s, c);
+		}
+		p = c->free;
+		c->free = p->hnext;
+
+		p->lpn = lpn;
+		p->prefetched = 0;
+		p->hnext = c->hash[lpn % c->num_pages];
+		c->hash[lpn % c->num_pages] = p;
+	}
+
+	p->dirty = 1;
+	ssd_cache_push_mru(c, p);
+	return n;
+}
+
+/*
+ * puts a page read from the elements in the buffer, as a clean page.
+ * the page takes a free slot or the place of a clean page, and is not
+ * kept if only dirty pages could make room for it. returns 1 if the
+ * page was put in the buffer.
+ */
+int ssd_cache_fill(ssd_t *s, int lpn, int prefetched)
+{
+	ssd_cache *c = s->cache;
+	ssd_cache_page *p;
+	int limit = 1;
+	int i;
+
+	if (ssd_cache_lookup(c, lpn) != NULL) {
+		return 0;
+	}
+
+	// the lru page, or the first clean page of the cflru window
+	if (c->free == NULL) {
+		if ((s->params.buffer_cache_policy == SSD_BUFFER_CACHE_CFLRU) && (c->window > 1)) {
+			limit = c->window;
+		}
+		for (p = c->lru, i = 0; (p != NULL) && (i < limit); p = p->prev, i ++) {
+			if (!p->dirty) {
+				break;
+			}
+		}
+		if ((p == NULL) || (i == limit)) {
+			return 0;
+		}
+		ssd_cache_remove(s, c, p);
+	}
+
+	p = c->free;
+	c->free = p->hnext;
+
+	p->lpn = lpn;
+	p->dirty = 0;
+	p->prefetched = prefetched;
+	p->hnext = c->hash[lpn % c->num_pages];
+	c->hash[lpn % c->num_pages] = p;
+	ssd_cache_push_mru(c, p);
+	return 1;
+}
+
+/*
+ * follows the sequential streams of reads. a read of the pages [first,
+ * last] that continues a stream returns the number of pages to read
+ * ahead, starting at *start. the other reads start a new stream.
+ */
+int ssd_cache_readahead(ssd_t *s, int first, int last, int *start)
+{
+	ssd_cache *c = s->cache;
+	int end = last + 1 + s->params.read_ahead;
+	int i;
+
+	for (i = 0; i < SSD_CACHE_STREAMS; i ++) {
+		if (c->stream_next[i] == first) {
+			break;
+		}
+	}
+
+	if (i == SSD_CACHE_STREAMS) {
+		i = c->stream_victim;
+		c->stream_victim = (i + 1) % SSD_CACHE_STREAMS;
+		c->stream_next[i] = last + 1;
+		c->stream_end[i] = last + 1;
+		return 0;
+	}
+
+	*start = (c->stream_end[i] > last + 1) ? c->stream_end[i] : last + 1;
+	c->stream_next[i] = last + 1;
+	if (*start >= end) {
+		return 0;
+	}
+	c->stream_end[i] = end;
+	return end - *start;
+}
+
+/*
+ * the dram serves 'bcount' sectors. returns the time at which the access
+ * is over, and charges the active energy of the dram for it.
+ */
+double ssd_cache_access(ssd_t *s, int bcount)
+{
+	ssd_cache *c = s->cache;
+	double time = bcount * SSD_DATA_BYTES_PER_SECTOR * s->params.dram_active_latency;
+	double start = (c->busy_until > simtime) ? c->busy_until : simtime;
+
+	c->busy_until = start + time;
+	ssd_power_ssd_calculate(SSD_POWER_DRAM_ACCESS, time, s);
+	ssd_power_profile_dram(s, start, c->busy_until);
+
+	return c->busy_until;
+}
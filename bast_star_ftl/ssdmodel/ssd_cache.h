@@ -0,0 +1,54 @@
+#ifndef DISKSIM_SSD_CACHE_H
+#define DISKSIM_SSD_CACHE_H
+
+#include "ssd.h"
+
+/*
+ * the dram of the controller holds a write-back buffer of logical pages
+ * in front of the ftl. the writes are absorbed by the buffer and the
+ * reads of the pages it holds are served from it. the dirty pages are
+ * destaged to the elements, in batches taken from the lru end, when a
+ * new page needs room. with SSD_BUFFER_CACHE_CFLRU, a clean page in the
+ * window at the lru end is evicted before a dirty one.
+ *
+ * with "Read cache" set, the pages read from the elements are kept in
+ * the buffer as clean pages, and a read that continues one of the
+ * last SSD_CACHE_STREAMS reads prefetches the next "Read ahead" pages
+ * into it. clean pages never evict dirty ones.
+ */
+#define SSD_CACHE_STREAMS		8
+
+typedef struct _ssd_cache_page {
+	int lpn;
+	int dirty;
+	int prefetched;						// read ahead and not hit yet
+	struct _ssd_cache_page *prev;		// towards the mru end
+	struct _ssd_cache_page *next;		// towards the lru end
+	struct _ssd_cache_page *hnext;		// hash chain
+} ssd_cache_page;
+
+struct _ssd_cache {
+	int num_pages;						// capacity of the buffer
+	int window;							// pages at the lru end evicted clean first
+	int batch;							// dirty pages destaged at once
+	ssd_cache_page *pages;
+	ssd_cache_page *free;
+	ssd_cache_page *mru;
+	ssd_cache_page *lru;
+	ssd_cache_page **hash;
+	int *destage;						// lpns of the batch being destaged
+	double busy_until;					// the dram is accessed one request at a time
+	int stream_next[SSD_CACHE_STREAMS];	// next lpn of each sequential stream
+	int stream_end[SSD_CACHE_STREAMS];	// end of the pages read ahead for it
+	int stream_victim;
+};
+
+void ssd_cache_init(ssd_t *s);
+int ssd_cache_holds(ssd_t *s, int lpn);
+int ssd_cache_read(ssd_t *s, int lpn);
+int ssd_cache_write(ssd_t *s, int lpn, int **destage);
+int ssd_cache_fill(ssd_t *s, int lpn, int prefetched);
+int ssd_cache_readahead(ssd_t *s, int first, int last, int *start);
+double ssd_cache_access(ssd_t *s, int bcount);
+
+#endif
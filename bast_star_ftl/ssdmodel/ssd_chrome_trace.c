@@ -0,0 +1,147 @@
+
+#include "ssd.h"
+#include "ssd_chrome_trace.h"
+
+// each element has an operation and a gc track, followed by the channels
+#define SSD_CHROME_TRACKS		(2 * SSD_MAX_ELEMENTS + MAX_CHANNEL)
+
+// spans that overlap on a track are drawn on up to this many rows
+#define SSD_CHROME_LANES		8
+
+struct _ssd_chrome_trace {
+	FILE *fp;
+	int devno;
+	double start;					// the window of simulated time (ms)
+	double end;
+	double lane_end[SSD_CHROME_TRACKS][SSD_CHROME_LANES];
+	char lane_named[SSD_CHROME_TRACKS][SSD_CHROME_LANES];
+	struct _ssd_chrome_trace *next;
+};
+
+// the open traces, closed at exit
+static ssd_chrome_trace *chrome_traces = NULL;
+
+static void ssd_chrome_trace_close_all(void)
+{
+	ssd_chrome_trace *t;
+
+	while ((t = chrome_traces) != NULL) {
+		chrome_traces = t->next;
+
+		fprintf(t->fp, "\n],\n\"displayTimeUnit\": \"ms\"\n}\n");
+		fclose(t->fp);
+		free(t);
+	}
+}
+
+void ssd_chrome_trace_init(ssd_t *s)
+{
+	ssd_chrome_trace *t;
+	char name[64];
+
+	if ((!s->params.chrome_trace) || (s->chrome_trace != NULL)) {
+		return;
+	}
+
+	if ((t = (ssd_chrome_trace *)malloc(sizeof(ssd_chrome_trace))) == NULL) {
+		fprintf(stderr, "Error: malloc to chrome_trace in ssd_chrome_trace_init failed\n");
+		fprintf(stderr, "Allocation size = %d\n", (int)sizeof(ssd_chrome_trace));
+		exit(1);
+	}
+	memset(t, 0, sizeof(ssd_chrome_trace));
+
+	sprintf(name, "ssd%d.trace.json", s->devno);
+	if ((t->fp = fopen(name, "w")) == NULL) {
+		fprintf(stderr, "Error: cannot open %s\n", name);
+		exit(1);
+	}
+	t->devno = s->devno;
+	t->start = s->params.chrome_trace_start;
+	t->end = s->params.chrome_trace_end;
+
+	fprintf(t->fp, "{\n\"traceEvents\": [\n");
+	fprintf(t->fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"ssd %d\"}}",
+		t->devno, t->devno);
+
+	if (chrome_traces == NULL) {
+		atexit(ssd_chrome_trace_close_all);
+	}
+	t->next = chrome_traces;
+	chrome_traces = t;
+
+	s->chrome_trace = t;
+}
+
+// names the row of a track the first time a span is drawn on it
+static void ssd_chrome_trace_name(ssd_chrome_trace *t, ssd_chrome_track_t type, int num, int track, int lane)
+{
+	static char *type_names[] = { "elem", "elem", "channel" };
+	int tid = track * SSD_CHROME_LANES + lane;
+
+	fprintf(t->fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s %d%s",
+		t->devno, tid, type_names[type], num, (type == SSD_CHROME_GC) ? " gc" : "");
+	if (lane > 0) {
+		fprintf(t->fp, " (%d)", lane + 1);
+	}
+	fprintf(t->fp, "\"}},\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+		t->devno, tid, tid);
+
+	t->lane_named[track][lane] = 1;
+}
+
+/*
+ * writes a span of the element, gc or channel track 'num'. the spans of
+ * a track have to nest, so a span that overlaps the previous ones goes
+ * to the first row of the track that is free at its start.
+ */
+void ssd_chrome_trace_span(ssd_t *s, ssd_chrome_track_t type, int num, char *name, double start, double end, int blkno)
+{
+	ssd_chrome_trace *t = s->chrome_trace;
+	int track, lane, i;
+
+	if (t == NULL) {
+		return;
+	}
+	if ((end < t->start) || ((t->end > 0) && (start > t->end))) {
+		return;
+	}
+
+	switch (type) {
+	case SSD_CHROME_ELEM:
+		track = 2 * num;
+	break;
+
+	case SSD_CHROME_GC:
+		track = 2 * num + 1;
+	break;
+
+	default:
+		track = 2 * SSD_MAX_ELEMENTS + num;
+	break;
+	}
+
+	// if every row is busy, the one that frees up first is used
+	lane = 0;
+	for (i = 0; i < SSD_CHROME_LANES; i ++) {
+		if (t->lane_end[track][i] <= start) {
+			lane = i;
+			break;
+		}
+		if (t->lane_end[track][i] < t->lane_end[track][lane]) {
+			lane = i;
+		}
+	}
+	t->lane_end[track][lane] = end;
+
+	if (!t->lane_named[track][lane]) {
+		ssd_chrome_trace_name(t, type, num, track, lane);
+	}
+
+	// the trace event times are in microseconds
+	fprintf(t->fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d",
+		name, start * 1000, (end - start) * 1000, t->devno, track * SSD_CHROME_LANES + lane);
+	if (blkno >= 0) {
+		fprintf(t->fp, ", \"args\": {\"blkno\": %d}", blkno);
+	}
+	fprintf(t->fp, "}");
+}
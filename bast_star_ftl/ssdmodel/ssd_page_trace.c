@@ -0,0 +1,45 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssd_page_trace.h"
+
+// one trace for the reads and one for the writes
+#define SSD_PAGE_TRACE_FILES	2
+
+static struct {
+	FILE *fp;
+	ssd_trace *trace;
+} page_traces[SSD_PAGE_TRACE_FILES];
+
+static ssd_trace *ssd_page_trace_find(FILE *fp)
+{
+	int i;
+
+	for (i = 0; i < SSD_PAGE_TRACE_FILES; i ++) {
+		if (page_traces[i].fp == fp) {
+			return page_traces[i].trace;
+		}
+		if (page_traces[i].fp == NULL) {
+			page_traces[i].fp = fp;
+			page_traces[i].trace = ssd_trace_open(fp, SSD_PAGE_TRACE_MAGIC, sizeof(ssd_page_record));
+			return page_traces[i].trace;
+		}
+	}
+
+	fprintf(stderr, "Error: too many page trace files in ssd_page_trace_find\n");
+	exit(1);
+}
+
+void ssd_page_trace_append(FILE *fp, double time, int lpn, int elem_num, int blkno, char tag)
+{
+	ssd_page_record rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.time = time;
+	rec.lpn = lpn;
+	rec.elem_num = elem_num;
+	rec.blkno = blkno;
+	rec.tag = tag;
+	ssd_trace_append(ssd_page_trace_find(fp), &rec);
+}
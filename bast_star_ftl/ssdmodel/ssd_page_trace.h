@@ -0,0 +1,25 @@
+#ifndef DISKSIM_SSD_PAGE_TRACE_H
+#define DISKSIM_SSD_PAGE_TRACE_H
+
+#include <stdio.h>
+#include "ssd_trace.h"
+
+/*
+ * the pages read and written by the elements are traced to outputfile5
+ * and outputfile4 as fixed size binary records. ssd_page_conv turns a
+ * trace back into the "time lpn elem blkno" text lines.
+ */
+#define SSD_PAGE_TRACE_MAGIC		"SSDPAG01"
+
+typedef struct _ssd_page_record {
+	double time;
+	int lpn;
+	int elem_num;
+	int blkno;
+	char tag;					// printed after the record, 0 if none
+	char pad[3];
+} ssd_page_record;
+
+void ssd_page_trace_append(FILE *fp, double time, int lpn, int elem_num, int blkno, char tag);
+
+#endif
@@ -1,39 +1,294 @@
 
 #include "ssd.h"
 #include "ssd_power.h"
+#include "ssd_power_trace.h"
+
+// the voltage of the ssd bus
+#define SSD_POWER_BUS_VOLTAGE	5
+
+// the power timeline is sampled at fixed periods, unless the
+// power profile writes out the exact curve.
+#define SSD_POWER_SAMPLING(s)	(((s)->params.power_sample_period > 0) && \
+								 ((s)->params.power_profile != SSD_POWER_PROFILE_CURVE))
+
+// initial number of bins of the power sampler
+#define SSD_POWER_SAMPLER_BINS	64
+
+static void ssd_power_sampler_init(ssd_t *s)
+{
+	ssd_power_sampler *ps = &(s->power_sampler);
+
+	ps->base_power = s->params.nelements * s->power_totals.flash_idle_power +
+					s->params.cpu_idle_mode_power + s->params.leakage_power +
+					s->params.dram_idle_current * s->params.dram_input_voltage;
+	ps->active_energy = 0.0;
+
+	if (ps->bins == NULL) {
+		ps->nbins = SSD_POWER_SAMPLER_BINS;
+		if ((ps->bins = (double *)malloc(ps->nbins * sizeof(double))) == NULL) {
+			fprintf(stderr, "Error: malloc to bins in ssd_power_sampler_init failed\n");
+			fprintf(stderr, "Allocation size = %d\n", ps->nbins * sizeof(double));
+			exit(1);
+		}
+	}
+	memset(ps->bins, 0, ps->nbins * sizeof(double));
+	ps->first = 0;
+	ps->start = simtime;
+	ps->current_sum = 0.0;
+	ps->current_time = simtime;
+	ps->end = simtime;
+}
+
+/*
+ * precomputes the power drawn by each type of operation and
+ * clears the running energy totals of the ssd.
+ */
+void ssd_power_init(ssd_t *s)
+{
+	ssd_power_totals *t = &(s->power_totals);
+
+	t->read_power = s->params.flash_input_voltage * s->params.page_read_current;
+	t->write_power = s->params.flash_input_voltage * s->params.page_write_current;
+	t->erase_power = s->params.flash_input_voltage * s->params.page_erase_current;
+	t->flash_bus_power = s->params.flash_input_voltage * s->params.flash_bus_current;
+	t->flash_idle_power = s->params.flash_input_voltage * s->params.flash_idle_current;
+	t->ssd_bus_power = SSD_POWER_BUS_VOLTAGE * s->params.ssd_bus_current;
+	t->ctrl_current = (s->params.cpu_normal_mode_power + s->params.leakage_power)/5 + s->params.dram_idle_current;
+
+	t->flash_energy = 0.0;
+	t->elem_acc_time = 0.0;
+	t->busy_elements = 0;
+
+	if (SSD_POWER_SAMPLING(s)) {
+		ssd_power_sampler_init(s);
+	}
+	ssd_power_profile_init(s);
+}
+
+// the current drawn by the ssd (in A) with its elements as they are now.
+static double ssd_power_current(ssd_t *s)
+{
+	ssd_power_totals *t = &(s->power_totals);
+
+	return t->ctrl_current + t->busy_elements * s->params.page_write_current +
+			(s->params.nelements - t->busy_elements) * s->params.flash_idle_current;
+}
+
+/*
+ * records the sampling periods that end before 'time'. the current
+ * has been constant since the last call, as the elements only become
+ * busy or idle when the sampler is advanced.
+ */
+static void ssd_power_sampler_advance(ssd_t *s, double time)
+{
+	ssd_power_sampler *ps = &(s->power_sampler);
+	double period = s->params.power_sample_period;
+	double current = ssd_power_current(s);
+	double end = ps->start + period;
+	double energy;
+
+	if (s->end_list == NULL) {
+		s->end_list = &(s->power_section);
+		ssd_power_trace_header(outputfile2);
+	}
+
+	while (end <= time) {
+		ps->current_sum += current * (end - ps->current_time);
+		energy = ps->base_power * period + ps->bins[ps->first];
+		ssd_power_trace_section(outputfile2, ps->start, ps->current_sum / period * 1000,
+								energy / period * 1000, period, energy);
+
+		ps->bins[ps->first] = 0.0;
+		ps->first = (ps->first + 1) & (ps->nbins - 1);
+		ps->start = end;
+		ps->current_time = end;
+		ps->current_sum = 0.0;
+		end = ps->start + period;
+	}
+	ps->current_sum += current * (time - ps->current_time);
+	ps->current_time = time;
+}
+
+/*
+ * the energy drawn above the idle power so far: the flash operations,
+ * the cpu and dram activity and the bus transfers.
+ */
+static double ssd_power_sampler_active(ssd_t *s)
+{
+	ssd_power_totals *t = &(s->power_totals);
+	ssd_power_ssd_stat *st = &(s->ssd_power_stat);
+
+	return t->flash_energy - t->flash_idle_power * t->elem_acc_time +
+			(s->params.cpu_normal_mode_power - s->params.cpu_idle_mode_power) * s->acc_time +
+			st->dram_power_consumed - s->params.dram_idle_current * s->params.dram_input_voltage * st->dram_time_consumed +
+			st->ssd_bus_power_consumed;
+}
+
+// doubles the bins until there are at least 'needed' of them.
+static void ssd_power_sampler_grow(ssd_power_sampler *ps, int needed)
+{
+	double *bins;
+	int n = ps->nbins;
+	int i;
+
+	while (n < needed) {
+		n *= 2;
+	}
+	if ((bins = (double *)malloc(n * sizeof(double))) == NULL) {
+		fprintf(stderr, "Error: malloc to bins in ssd_power_sampler_grow failed\n");
+		fprintf(stderr, "Allocation size = %d\n", n * sizeof(double));
+		exit(1);
+	}
+	for (i = 0; i < ps->nbins; i ++) {
+		bins[i] = ps->bins[(ps->first + i) & (ps->nbins - 1)];
+	}
+	for (; i < n; i ++) {
+		bins[i] = 0.0;
+	}
+	free(ps->bins);
+	ps->bins = bins;
+	ps->nbins = n;
+	ps->first = 0;
+}
+
+/*
+ * spreads the energy drawn above the idle power since the last call
+ * evenly over [simtime, simtime + cost]. the flash, cpu and bus energy
+ * of an activation is accounted before ssd_dpower is called.
+ */
+static void ssd_power_sampler_spread(ssd_t *s, double cost)
+{
+	ssd_power_sampler *ps = &(s->power_sampler);
+	double period = s->params.power_sample_period;
+	double active, rate, from, to, end;
+	int bin;
+
+	ssd_power_sampler_advance(s, simtime);
+
+	active = ssd_power_sampler_active(s);
+	rate = (active - ps->active_energy) / cost;
+	ps->active_energy = active;
+
+	end = simtime + cost;
+	if (ps->end < end) {
+		ps->end = end;
+	}
+	bin = (int)((end - ps->start) / period) + 1;
+	if (bin > ps->nbins) {
+		ssd_power_sampler_grow(ps, bin);
+	}
+
+	// simtime falls in the first period after advancing
+	from = simtime;
+	for (bin = 0; from < end; bin ++) {
+		ASSERT(bin < ps->nbins);
+		to = ps->start + (bin + 1) * period;
+		if (to > end) {
+			to = end;
+		}
+		ps->bins[(ps->first + bin) & (ps->nbins - 1)] += rate * (to - from);
+		from = to;
+	}
+}
+
+/*
+ * writes out the periods the events did not get to at the end of the
+ * run: those up to the end of the last energy spread into the bins, and
+ * the last one, which is cut short there. the energy drawn since the
+ * last spread goes into that last period, so the timeline holds all
+ * the energy of the run.
+ */
+void ssd_power_sampler_finish(ssd_t *s)
+{
+	ssd_power_sampler *ps = &(s->power_sampler);
+	double end, time, energy, active;
+
+	if ((!SSD_POWER_SAMPLING(s)) || (ps->bins == NULL)) {
+		return;
+	}
+
+	end = (ps->end > simtime) ? ps->end : simtime;
+	ssd_power_sampler_advance(s, end);
+
+	active = ssd_power_sampler_active(s);
+	ps->bins[ps->first] += active - ps->active_energy;
+	ps->active_energy = active;
+
+	time = end - ps->start;
+	if (time > 0) {
+		energy = ps->base_power * time + ps->bins[ps->first];
+		ssd_power_trace_section(outputfile2, ps->start, ps->current_sum / time * 1000,
+								energy / time * 1000, time, energy);
+
+		ps->bins[ps->first] = 0.0;
+		ps->first = (ps->first + 1) & (ps->nbins - 1);
+		ps->start = end;
+		ps->current_time = end;
+		ps->current_sum = 0.0;
+	}
+}
+
+/*
+ * marks the media of an element busy or free, keeping
+ * count of the busy elements.
+ */
+void ssd_set_media_busy(ssd_t *s, ssd_element *elem, int busy)
+{
+	if (elem->media_busy != busy) {
+		if (SSD_POWER_SAMPLING(s)) {
+			ssd_power_sampler_advance(s, simtime);
+		}
+		if (busy) {
+			s->power_totals.busy_elements ++;
+		} else {
+			s->power_totals.busy_elements --;
+		}
+		elem->media_busy = busy;
+	}
+}
+
+void ssd_power_add_acc_time(double time, ssd_power_element_stat *power_stat, ssd_t *s)
+{
+	power_stat->acc_time += time;
+	s->power_totals.elem_acc_time += time;
+	ssd_power_profile_settle(s, power_stat, time);
+}
 
 void ssd_power_flash_calculate(ssd_power_type_t type, double time, ssd_power_element_stat *power_stat, ssd_t *s)
 {
+	ssd_power_totals *t = &(s->power_totals);
 	double energy_value = 0.0;
 
 	switch(type)
 	{
 	case SSD_POWER_FLASH_READ:
-		energy_value = s->params.flash_input_voltage * s->params.page_read_current * time;
+		energy_value = t->read_power * time;
 		power_stat->num_reads++;
 		power_stat->read_power_consumed += energy_value;
 	break;
 
 	case SSD_POWER_FLASH_WRITE:
-		energy_value = s->params.flash_input_voltage * s->params.page_write_current * time;
+		energy_value = t->write_power * time;
 		power_stat->num_writes++;
 		power_stat->write_power_consumed += energy_value;
 	break;
 
 	case SSD_POWER_FLASH_ERASE:
-		energy_value = s->params.flash_input_voltage * s->params.page_erase_current * time;
+		energy_value = t->erase_power * time;
 		power_stat->num_erase++;
 		power_stat->erase_power_consumed += energy_value;
 	break;
 
 	case SSD_POWER_FLASH_BUS_DATA_TRANSFER:
-		energy_value = s->params.flash_input_voltage * s->params.flash_bus_current * time;
+		energy_value = t->flash_bus_power * time;
 		power_stat->bus_power_consumed += energy_value;
 	break;
 
 	default:
 	break;
 	}
+
+	t->flash_energy += energy_value;
 }
 
 void ssd_power_ssd_calculate(ssd_power_type_t type, double time, ssd_t *s)
@@ -44,11 +299,17 @@ void ssd_power_ssd_calculate(ssd_power_type_t type, double time, ssd_t *s)
 	switch(type)
 	{
 	case SSD_POWER_BUS_DATA_TRANSFER:
-		energy_value = 5 * s->params.ssd_bus_current * time;
+		energy_value = s->power_totals.ssd_bus_power * time;
 		ssd_power_stat->ssd_bus_power_consumed += energy_value;
 		ssd_power_stat->ssd_bus_time_consumed += time;
 	break;
 
+	case SSD_POWER_DRAM_ACCESS:
+		energy_value = s->params.dram_active_current * s->params.dram_input_voltage * time;
+		ssd_power_stat->dram_power_consumed += energy_value;
+		ssd_power_stat->dram_time_consumed += time;
+	break;
+
 	default:
 	break;
 	}
@@ -56,7 +317,8 @@ void ssd_power_ssd_calculate(ssd_power_type_t type, double time, ssd_t *s)
 // version 1.0 by tiel
 void power_update(ssd_t *s, double cost)
 {
-	int i, busy;
+	ssd_power_totals *t = &(s->power_totals);
+	int n = s->params.nelements;
 	double total_energy = 0.0;
 	double cpu_active_energy = 0.0;
 	double cpu_idle_energy = 0.0;
@@ -67,41 +329,22 @@ void power_update(ssd_t *s, double cost)
 	double leakage_energy = 0.0;
 	double time = 0.0;
 	double idle_current_elem = 0.0;
-	double idle_current;
-
-	busy = 0;
-	for (i = 0; i < s->params.nelements; i ++) {
-		double element_total_energy = 0.0;
-		double element_idle_time = 0.0;
-		double element_idle_energy = 0.0;
-		double element_active_energy = 0.0;
-		ssd_power_element_stat *stat = &(s->elements[i].power_stat);
+	double end_time;
+
+	// get the element energy: the active energy of all the elements is
+	// kept as a running total and each element idles for the time it
+	// was not accessed.
+	if((simtime+cost) > (s->section + s->prev_cost)){
+		end_time = simtime + cost;
+	}else{
+		end_time = s->section + s->prev_cost;
+	}
+	total_energy += t->flash_energy;
+	total_energy += t->flash_idle_power * (n * end_time - t->elem_acc_time);
 
-		// get idle energy
-		//element_idle_time = s->section + s->current_cost - warmuptime - stat->acc_time;
-		//element_idle_time = s->acc_time - stat->acc_time;
-		if((simtime+cost) > (s->section + s->prev_cost)){
-			element_idle_time = simtime + cost - stat->acc_time;
-		}else{
-			element_idle_time = s->section + s->prev_cost - stat->acc_time;
-		}
-		element_idle_energy = s->params.flash_input_voltage * s->params.flash_idle_current * element_idle_time;
+	idle_current_elem = t->busy_elements * s->params.page_write_current +
+						(n - t->busy_elements) * s->params.flash_idle_current;
 
-		// get active energy
-		element_active_energy += stat->read_power_consumed + stat->write_power_consumed + 
-								stat->erase_power_consumed + stat->bus_power_consumed; 
-		// get total element energy
-		element_total_energy = stat->read_power_consumed + stat->write_power_consumed + 
-								stat->erase_power_consumed + stat->bus_power_consumed + element_idle_energy;
-
-		total_energy += element_total_energy;
-		if(s->elements[i].media_busy == 1) {
-			idle_current_elem += s->params.page_write_current;
-			busy++;
-		} else {
-			idle_current_elem += s->params.flash_idle_current;
-		}
-	}
 	// get CPU energy
 	cpu_idle_time = simtime + cost - s->acc_time;
 	cpu_active_energy = s->params.cpu_normal_mode_power * s->acc_time;
@@ -112,8 +355,8 @@ void power_update(ssd_t *s, double cost)
 
 	//ram energy
 	//ram_active_energy = s->params.dram_active_current * s->params.dram_input_voltage * cpu_active_time;
-	ram_active_energy = 0.0;
-	ram_idle_energy = s->params.dram_idle_current * s->params.dram_input_voltage * simtime;
+	ram_active_energy = s->ssd_power_stat.dram_power_consumed;
+	ram_idle_energy = s->params.dram_idle_current * s->params.dram_input_voltage * (simtime - s->ssd_power_stat.dram_time_consumed);
 
 	total_energy += ram_active_energy;
 	total_energy += ram_idle_energy;
@@ -156,8 +399,7 @@ void power_update(ssd_t *s, double cost)
 			s->power_section.power = power * 1000;
 		}
 	}
-	idle_current = (s->params.cpu_normal_mode_power + s->params.leakage_power)/5 + s->params.dram_idle_current;
-	s->power_section.current = (idle_current + idle_current_elem) * 1000;
+	s->power_section.current = (t->ctrl_current + idle_current_elem) * 1000;
 }
 //*/
 /*
@@ -284,16 +526,14 @@ void print_power_start(ssd_t *s)
 		
 		tmp.energy = (s->params.cpu_idle_mode_power + s->params.leakage_power) + idle_power_ram;
 		
-		fprintf(outputfile2, "#SSD Power Distribution \n");
-		fprintf(outputfile2, "#time(mSec),Current(mA),Power(mW),Cost(mSec),TOTAL_P(mJ),\n"); 
-		fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", time, tmp.current, tmp.power, tmp.cost, tmp.energy);
+		ssd_power_trace_header(outputfile2);
+		ssd_power_trace_section(outputfile2, time, tmp.current, tmp.power, tmp.cost, tmp.energy);
 
 		if(simtime>0.1){
 			time = simtime - 0.1;
-			fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", time, tmp.current, tmp.power, tmp.cost, tmp.energy);
-			fflush (outputfile2);
+			ssd_power_trace_section(outputfile2, time, tmp.current, tmp.power, tmp.cost, tmp.energy);
 		}
-		fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", simtime, s->power_section.current, s->power_section.power, s->power_section.cost, s->	power_section.energy); 
+		ssd_power_trace_section(outputfile2, simtime, s->power_section.current, s->power_section.power, s->power_section.cost, s->power_section.energy);
 	}else {
 		time = simtime - (s->section + s->prev_cost);
 		if(time > 0.2) {
@@ -305,40 +545,25 @@ void print_power_start(ssd_t *s)
 				i++;
 			}*/
 			tmp.time = s->section + s->prev_cost + 0.1;		
-			fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", tmp.time, tmp.current, tmp.power, tmp.cost, tmp.energy); 
+			ssd_power_trace_section(outputfile2, tmp.time, tmp.current, tmp.power, tmp.cost, tmp.energy);
 			tmp.time = simtime - 0.1;		
-			fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", tmp.time, tmp.current, tmp.power, tmp.cost, tmp.energy); 
+			ssd_power_trace_section(outputfile2, tmp.time, tmp.current, tmp.power, tmp.cost, tmp.energy);
 		}
-		fprintf(outputfile2, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", simtime, s->power_section.current, s->power_section.power, s->power_section.cost, s->power_section.energy); 
-		fflush (outputfile2);
+		ssd_power_trace_section(outputfile2, simtime, s->power_section.current, s->power_section.power, s->power_section.cost, s->power_section.energy);
 	}
 }
 
 void print_power_end(ssd_t *s)
 {
-	int i, busy, waiting;
-	double idle_current_elem = 0.0;
-	double idle_current;
-
-	busy = 0;
-	waiting = 0;
-	for (i = 0; i < s->params.nelements; i ++) {
-		ssd_power_element_stat *stat = &(s->elements[i].power_stat);
-		waiting += s->elements[i].metadata.reqs_waiting;
+	ssd_power_totals *t = &(s->power_totals);
+	double idle_current_elem;
 
-		if(s->elements[i].media_busy == 1) {
-			idle_current_elem += s->params.page_write_current;
-			busy++;
-		} else {
-			idle_current_elem += s->params.flash_idle_current;
-		}
-	}
+	idle_current_elem = t->busy_elements * s->params.page_write_current +
+						(s->params.nelements - t->busy_elements) * s->params.flash_idle_current;
 
-	idle_current = (s->params.cpu_normal_mode_power + s->params.leakage_power)/5 + s->params.dram_idle_current;
-	s->power_section.current = (idle_current + idle_current_elem) * 1000;
+	s->power_section.current = (t->ctrl_current + idle_current_elem) * 1000;
 
-	fprintf(outputfile2, "%6.4f,%6.4f,\n", simtime, s->power_section.current); 
-	fflush (outputfile2);
+	ssd_power_trace_current(outputfile2, simtime, s->power_section.current);
 
 	/*if((busy ==1) && (waiting == 0)){
 		double time;
@@ -355,20 +580,34 @@ void print_power_end(ssd_t *s)
 
 void ssd_dpower(ssd_t *s, double cost) 
 {
+	double prof = ssd_prof_begin(s);
+
+	ssd_power_profile_advance(s, simtime);
+
 	if(cost == 0) {
-		print_power_end(s);
+		if (SSD_POWER_SAMPLING(s)) {
+			ssd_power_sampler_advance(s, simtime);
+		} else if (s->params.power_profile != SSD_POWER_PROFILE_CURVE) {
+			print_power_end(s);
+		}
 	}else {
 		double p_time = s->section + s->prev_cost;
 		double c_time = simtime + cost;
 
 		if( simtime > p_time){
 			s->acc_time += cost;
+			ssd_power_profile_cpu(s, simtime, c_time);
 		}else if (c_time > p_time){
 			s->acc_time += (c_time - p_time);	
+			ssd_power_profile_cpu(s, p_time, c_time);
 		}
 
-		power_update(s, cost);
-		print_power_start(s);
+		if (SSD_POWER_SAMPLING(s)) {
+			ssd_power_sampler_spread(s, cost);
+		} else if (s->params.power_profile != SSD_POWER_PROFILE_CURVE) {
+			power_update(s, cost);
+			print_power_start(s);
+		}
 		
 		//s->prev_time = s->section;
 		if(c_time > p_time){
@@ -380,6 +619,8 @@ void ssd_dpower(ssd_t *s, double cost)
 		//s->prev_energy += s->power_section.energy;
 		s->section = simtime;
 	}
+
+	ssd_prof_end(s, SSD_PROF_POWER, prof);
 	//else{
 	//	/*if((cost > s->current_cost) && (simtime == s->section))
 	//	{
@@ -0,0 +1,375 @@
+
+#include "ssd.h"
+#include "ssd_power.h"
+#include "ssd_power_trace.h"
+
+// the voltage of the controller (cpu and leakage) currents
+#define SSD_POWER_CTRL_VOLTAGE		5
+
+// initial number of edges of the heap
+#define SSD_POWER_PROFILE_EDGES		1024
+
+// power differences below this are rounding errors
+#define SSD_POWER_PROFILE_EPSILON	1e-9
+
+static void ssd_power_profile_push(ssd_power_profile *p, double time, double current, double power)
+{
+	ssd_power_edge e;
+	int i, parent;
+
+	if (p->num_edges == p->max_edges) {
+		p->max_edges *= 2;
+		if ((p->edges = (ssd_power_edge *)realloc(p->edges, p->max_edges * sizeof(ssd_power_edge))) == NULL) {
+			fprintf(stderr, "Error: realloc to edges in ssd_power_profile_push failed\n");
+			fprintf(stderr, "Allocation size = %d\n", p->max_edges * sizeof(ssd_power_edge));
+			exit(1);
+		}
+	}
+
+	e.time = time;
+	e.current = current;
+	e.power = power;
+
+	// sift up
+	i = p->num_edges ++;
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (p->edges[parent].time <= time) {
+			break;
+		}
+		p->edges[i] = p->edges[parent];
+		i = parent;
+	}
+	p->edges[i] = e;
+}
+
+static void ssd_power_profile_pop(ssd_power_profile *p)
+{
+	ssd_power_edge last = p->edges[-- p->num_edges];
+	int i = 0;
+	int child;
+
+	// sift down
+	while ((child = 2*i + 1) < p->num_edges) {
+		if ((child + 1 < p->num_edges) && (p->edges[child + 1].time < p->edges[child].time)) {
+			child ++;
+		}
+		if (last.time <= p->edges[child].time) {
+			break;
+		}
+		p->edges[i] = p->edges[child];
+		i = child;
+	}
+	p->edges[i] = last;
+}
+
+/*
+ * adds an interval during which the ssd draws 'current' more at
+ * 'voltage'. the intervals must not start before simtime.
+ */
+static void ssd_power_profile_add(ssd_power_profile *p, double start, double end, double current, double voltage)
+{
+	if (start < p->time) {
+		start = p->time;
+	}
+	if (end <= start) {
+		return;
+	}
+
+	ssd_power_profile_push(p, start, current, current * voltage);
+	ssd_power_profile_push(p, end, -current, -current * voltage);
+}
+
+void ssd_power_profile_init(ssd_t *s)
+{
+	ssd_power_profile *p;
+	double max_power;
+	double op_power;
+	int n = s->params.nelements;
+
+	if (s->params.power_profile == SSD_POWER_PROFILE_OFF) {
+		s->power_profile = NULL;
+		return;
+	}
+
+	if ((p = (ssd_power_profile *)malloc(sizeof(ssd_power_profile))) == NULL) {
+		fprintf(stderr, "Error: malloc to power_profile in ssd_power_profile_init failed\n");
+		fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_power_profile));
+		exit(1);
+	}
+	memset(p, 0, sizeof(ssd_power_profile));
+
+	p->max_edges = SSD_POWER_PROFILE_EDGES;
+	if ((p->edges = (ssd_power_edge *)malloc(p->max_edges * sizeof(ssd_power_edge))) == NULL) {
+		fprintf(stderr, "Error: malloc to edges in ssd_power_profile_init failed\n");
+		fprintf(stderr, "Allocation size = %d\n", p->max_edges * sizeof(ssd_power_edge));
+		exit(1);
+	}
+
+	if ((p->channel_free = (double *)malloc(s->params.nchannel * sizeof(double))) == NULL) {
+		fprintf(stderr, "Error: malloc to channel_free in ssd_power_profile_init failed\n");
+		fprintf(stderr, "Allocation size = %d\n", s->params.nchannel * sizeof(double));
+		exit(1);
+	}
+	memset(p->channel_free, 0, s->params.nchannel * sizeof(double));
+
+	// the ssd starts with the controller, the dram and all the elements idle
+	p->time = simtime;
+	p->current = (s->params.cpu_idle_mode_power + s->params.leakage_power) / SSD_POWER_CTRL_VOLTAGE +
+				s->params.dram_idle_current + n * s->params.flash_idle_current;
+	p->power = s->params.cpu_idle_mode_power + s->params.leakage_power +
+				s->params.dram_idle_current * s->params.dram_input_voltage +
+				n * s->power_totals.flash_idle_power;
+	p->level_start = p->time;
+	p->level_current = p->current;
+	p->level_power = p->power;
+
+	// the histogram covers the power drawn when every parallel unit
+	// of every element is busy and all the pins are transferring.
+	op_power = s->power_totals.read_power;
+	if (op_power < s->power_totals.write_power) {
+		op_power = s->power_totals.write_power;
+	}
+	if (op_power < s->power_totals.erase_power) {
+		op_power = s->power_totals.erase_power;
+	}
+	max_power = p->power + s->params.cpu_normal_mode_power - s->params.cpu_idle_mode_power +
+				n * (SSD_PARUNITS_PER_ELEM(s) * op_power + s->power_totals.flash_bus_power);
+	p->bin_width = max_power / SSD_POWER_PROFILE_BINS;
+
+	s->power_profile = p;
+}
+
+// accounts the level of the curve between p->time and 'time'.
+static void ssd_power_profile_level(ssd_t *s, ssd_power_profile *p, double time)
+{
+	double dt = time - p->time;
+	int bin;
+
+	if (dt <= 0) {
+		return;
+	}
+
+	p->tot_time += dt;
+	bin = (int)(p->power / p->bin_width);
+	if (bin >= SSD_POWER_PROFILE_BINS) {
+		bin = SSD_POWER_PROFILE_BINS - 1;
+	} else if (bin < 0) {
+		bin = 0;
+	}
+	p->hist[bin] += dt;
+
+	if (p->power > p->peak_power) {
+		p->peak_power = p->power;
+		p->peak_time = p->time;
+	}
+	if (p->current > p->peak_current) {
+		p->peak_current = p->current;
+	}
+	if ((s->params.power_budget > 0) && (p->power * 1000 > s->params.power_budget)) {
+		p->over_budget += dt;
+	}
+
+	p->time = time;
+}
+
+// writes out the level that lasted until 'time' and starts the next one.
+static void ssd_power_profile_emit(ssd_t *s, ssd_power_profile *p, double time)
+{
+	double dt = time - p->level_start;
+
+	if (dt <= 0) {
+		return;
+	}
+
+	if (s->end_list == NULL) {
+		s->end_list = &(s->power_section);
+		ssd_power_trace_header(outputfile2);
+	}
+	ssd_power_trace_section(outputfile2, p->level_start, p->level_current * 1000,
+							p->level_power * 1000, dt, p->level_power * dt);
+
+	p->level_start = time;
+	p->level_current = p->current;
+	p->level_power = p->power;
+}
+
+// writes out the level that lasted until 'time' if the curve changes there.
+static void ssd_power_profile_write(ssd_t *s, ssd_power_profile *p, double time)
+{
+	double diff = p->power - p->level_power;
+
+	// the edges of an interval may not cancel out exactly
+	if ((diff < SSD_POWER_PROFILE_EPSILON) && (diff > -SSD_POWER_PROFILE_EPSILON)) {
+		return;
+	}
+	ssd_power_profile_emit(s, p, time);
+}
+
+/*
+ * sweeps the edges up to 'time'. a level is only written out once all
+ * the edges at its end are applied, so that coinciding edges do not
+ * produce zero length levels.
+ */
+void ssd_power_profile_advance(ssd_t *s, double time)
+{
+	ssd_power_profile *p = s->power_profile;
+	ssd_power_edge *e;
+
+	if (p == NULL) {
+		return;
+	}
+
+	while ((p->num_edges > 0) && (p->edges[0].time <= time)) {
+		e = &p->edges[0];
+		if (e->time > p->time) {
+			if (s->params.power_profile == SSD_POWER_PROFILE_CURVE) {
+				ssd_power_profile_write(s, p, p->time);
+			}
+			ssd_power_profile_level(s, p, e->time);
+		}
+		p->current += e->current;
+		p->power += e->power;
+		ssd_power_profile_pop(p);
+	}
+}
+
+/*
+ * places a flash operation that starts 'offset' after the start of
+ * the operations being timed on the element. the transfers go on the
+ * channel of the element, which carries one transfer at a time.
+ */
+void ssd_power_profile_op(ssd_t *s, int elem_num, ssd_power_type_t type, double offset, double time)
+{
+	ssd_power_profile *p = s->power_profile;
+	ssd_power_element_stat *power_stat = &(s->elements[elem_num].power_stat);
+	double *channel_free;
+	double current;
+	double start;
+
+	if (p == NULL) {
+		return;
+	}
+
+	switch(type)
+	{
+	case SSD_POWER_FLASH_READ:
+		current = s->params.page_read_current;
+	break;
+
+	case SSD_POWER_FLASH_WRITE:
+		current = s->params.page_write_current;
+	break;
+
+	case SSD_POWER_FLASH_ERASE:
+		current = s->params.page_erase_current;
+	break;
+
+	case SSD_POWER_FLASH_BUS_DATA_TRANSFER:
+		current = s->params.flash_bus_current;
+	break;
+
+	default:
+		return;
+	}
+
+	if (power_stat->profile_start < simtime) {
+		power_stat->profile_start = simtime;
+	}
+	start = power_stat->profile_start + offset;
+
+	// the elements that share a channel wait for its earlier transfers
+	if (type == SSD_POWER_FLASH_BUS_DATA_TRANSFER) {
+		channel_free = &p->channel_free[elem_num % s->params.nchannel];
+		if (start < *channel_free) {
+			start = *channel_free;
+		}
+		*channel_free = start + time;
+	}
+
+	ssd_power_profile_add(p, start, start + time, current, s->params.flash_input_voltage);
+	power_stat->profile_energy += s->params.flash_input_voltage * current * time;
+}
+
+/*
+ * the element is accessed for 'time' from the start of its operations.
+ * it does not draw the idle current for that time, and the energy of
+ * the operations that were not placed with ssd_power_profile_op is
+ * spread evenly over it.
+ */
+void ssd_power_profile_settle(ssd_t *s, ssd_power_element_stat *power_stat, double time)
+{
+	ssd_power_profile *p = s->power_profile;
+	double voltage = s->params.flash_input_voltage;
+	double start, energy;
+
+	if ((p == NULL) || (time <= 0)) {
+		return;
+	}
+
+	if (power_stat->profile_start < simtime) {
+		power_stat->profile_start = simtime;
+	}
+	start = power_stat->profile_start;
+
+	ssd_power_profile_add(p, start, start + time, -s->params.flash_idle_current, voltage);
+
+	energy = power_stat->read_power_consumed + power_stat->write_power_consumed +
+			power_stat->erase_power_consumed + power_stat->bus_power_consumed -
+			power_stat->profile_energy;
+	if (energy > 0) {
+		ssd_power_profile_add(p, start, start + time, energy / (voltage * time), voltage);
+		power_stat->profile_energy += energy;
+	}
+
+	// the next operations on the element start after these ones
+	power_stat->profile_start = start + time;
+}
+
+// the cpu is active between 'start' and 'end'.
+void ssd_power_profile_cpu(ssd_t *s, double start, double end)
+{
+	ssd_power_profile *p = s->power_profile;
+
+	if (p == NULL) {
+		return;
+	}
+
+	ssd_power_profile_add(p, start, end,
+		(s->params.cpu_normal_mode_power - s->params.cpu_idle_mode_power) / SSD_POWER_CTRL_VOLTAGE,
+		SSD_POWER_CTRL_VOLTAGE);
+}
+
+// the dram is accessed between 'start' and 'end'.
+void ssd_power_profile_dram(ssd_t *s, double start, double end)
+{
+	ssd_power_profile *p = s->power_profile;
+
+	if (p == NULL) {
+		return;
+	}
+
+	ssd_power_profile_add(p, start, end,
+		s->params.dram_active_current - s->params.dram_idle_current, s->params.dram_input_voltage);
+}
+
+// sweeps all the edges left and extends the curve to simtime.
+void ssd_power_profile_finish(ssd_t *s)
+{
+	ssd_power_profile *p = s->power_profile;
+
+	if (p == NULL) {
+		return;
+	}
+
+	while (p->num_edges > 0) {
+		ssd_power_profile_advance(s, p->edges[0].time);
+	}
+	if (s->params.power_profile == SSD_POWER_PROFILE_CURVE) {
+		ssd_power_profile_write(s, p, p->time);
+	}
+	ssd_power_profile_level(s, p, simtime);
+	if (s->params.power_profile == SSD_POWER_PROFILE_CURVE) {
+		ssd_power_profile_emit(s, p, p->time);
+	}
+}
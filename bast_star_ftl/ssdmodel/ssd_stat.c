@@ -1,6 +1,7 @@
 
 #include "ssd.h"
 #include "ftl.h"
+#include "ssd_trace.h"
 
 #ifndef sprintf_s
 #define sprintf_s3(x,y,z) sprintf(x,z)
@@ -30,16 +31,266 @@ static void ssd_other_printstats (int *set, int setsize, char *prefix)
 {
    int i;
    int numbuswaits = 0;
+   int activates_folded = 0;
+   int max_completion_qlen = 0;
+   int reqs_pooled = 0;
+   int req_allocs = 0;
    double waitingforbus = 0.0;
 
    for (i=0; i<setsize; i++) {
       ssd_t *currdisk = getssd (set[i]);
       numbuswaits += currdisk->stat.numbuswaits;
+      activates_folded += currdisk->stat.activates_folded;
       waitingforbus += currdisk->stat.waitingforbus;
+      if (max_completion_qlen < currdisk->stat.max_completion_qlen) {
+         max_completion_qlen = currdisk->stat.max_completion_qlen;
+      }
+      reqs_pooled += currdisk->stat.reqs_pooled;
+      req_allocs += currdisk->stat.req_allocs;
    }
 
    fprintf(outputfile, "%sTotal bus wait time: %f\n", prefix, waitingforbus);
    fprintf(outputfile, "%sNumber of bus waits: %d\n", prefix, numbuswaits);
+   fprintf(outputfile, "%sElement activations folded: %d\n", prefix, activates_folded);
+   fprintf(outputfile, "%sMax completion queue length: %d\n", prefix, max_completion_qlen);
+   fprintf(outputfile, "%sRequests taken from pool: %d\n", prefix, reqs_pooled);
+   fprintf(outputfile, "%sRequest heap allocations: %d\n", prefix, req_allocs);
+}
+
+static void ssd_cache_printstats (int *set, int setsize, char *prefix)
+{
+   int i;
+   int cached = 0;
+   int read_hits = 0;
+   int read_misses = 0;
+   int write_hits = 0;
+   int write_misses = 0;
+   int destages = 0;
+   int pages_destaged = 0;
+   int prefetches = 0;
+   int prefetch_hits = 0;
+   int prefetch_wasted = 0;
+   double prefetch_energy = 0.0;
+   double wasted_energy = 0.0;
+
+   for (i=0; i<setsize; i++) {
+      ssd_t *currdisk = getssd (set[i]);
+      if (currdisk->cache != NULL) {
+         cached = 1;
+      }
+      read_hits += currdisk->stat.cache_read_hits;
+      read_misses += currdisk->stat.cache_read_misses;
+      write_hits += currdisk->stat.cache_write_hits;
+      write_misses += currdisk->stat.cache_write_misses;
+      destages += currdisk->stat.cache_destages;
+      pages_destaged += currdisk->stat.cache_pages_destaged;
+      prefetches += currdisk->stat.cache_prefetches;
+      prefetch_hits += currdisk->stat.cache_prefetch_hits;
+      prefetch_wasted += currdisk->stat.cache_prefetch_wasted;
+
+      // the flash reads and transfers spent on the pages read ahead
+      {
+         double page_energy = currdisk->power_totals.read_power * currdisk->params.page_read_latency +
+            currdisk->power_totals.flash_bus_power * ssd_data_transfer_cost(currdisk, currdisk->params.page_size);
+         prefetch_energy += page_energy * currdisk->stat.cache_prefetches;
+         wasted_energy += page_energy * currdisk->stat.cache_prefetch_wasted;
+      }
+   }
+   if (!cached) {
+      return;
+   }
+
+   fprintf(outputfile, "%sBuffer cache read hits: %d\n", prefix, read_hits);
+   fprintf(outputfile, "%sBuffer cache read misses: %d\n", prefix, read_misses);
+   fprintf(outputfile, "%sBuffer cache read hit rate: %f\n", prefix,
+      (read_hits + read_misses > 0) ? ((double)read_hits / (read_hits + read_misses)) : 0.0);
+   fprintf(outputfile, "%sBuffer cache write hits: %d\n", prefix, write_hits);
+   fprintf(outputfile, "%sBuffer cache write misses: %d\n", prefix, write_misses);
+   fprintf(outputfile, "%sBuffer cache destages: %d\n", prefix, destages);
+   fprintf(outputfile, "%sBuffer cache pages destaged: %d\n", prefix, pages_destaged);
+   fprintf(outputfile, "%sBuffer cache pages read ahead: %d\n", prefix, prefetches);
+   fprintf(outputfile, "%sBuffer cache read ahead hits: %d\n", prefix, prefetch_hits);
+   fprintf(outputfile, "%sBuffer cache read ahead wasted: %d\n", prefix, prefetch_wasted);
+   fprintf(outputfile, "%sBuffer cache read ahead energy: %f mJ\n", prefix, prefetch_energy);
+   fprintf(outputfile, "%sBuffer cache read ahead energy wasted: %f mJ\n", prefix, wasted_energy);
+}
+
+static char *ssd_lat_phase_names[SSD_LAT_PHASES] = {
+   "queue", "channel", "element queue", "gc stall", "array", "transfer"
+};
+
+static void ssd_hist_print(ssd_hist *h, char *prefix, char *name)
+{
+   fprintf(outputfile, "%s%s:\t%lld\t%f\t%f\t%f\t%f\t%f\t%f\n", prefix, name, h->count,
+      ssd_hist_mean(h), ssd_hist_percentile(h, 0.5), ssd_hist_percentile(h, 0.99),
+      ssd_hist_percentile(h, 0.999), ssd_hist_percentile(h, 0.9999), h->max);
+}
+
+static void ssd_hist_print_header(char *prefix, char *title)
+{
+   fprintf(outputfile, "%s%s:\tcount\tmean\tp50\tp99\tp99.9\tp99.99\tmax\n", prefix, title);
+}
+
+static void ssd_lat_stat_merge(ssd_lat_stat *to, ssd_lat_stat *from)
+{
+   ssd_hist_merge(&to->read, &from->read);
+   ssd_hist_merge(&to->write, &from->write);
+   ssd_hist_merge(&to->gc, &from->gc);
+   ssd_hist_merge(&to->queue_wait, &from->queue_wait);
+}
+
+static void ssd_lat_stat_print(ssd_lat_stat *l, char *prefix)
+{
+   ssd_hist_print(&l->read, prefix, "Host read latency");
+   ssd_hist_print(&l->write, prefix, "Host write latency");
+   ssd_hist_print(&l->gc, prefix, "GC duration");
+   ssd_hist_print(&l->queue_wait, prefix, "Element queue wait");
+}
+
+/*
+ * prints the latency histograms of a set of ssds.
+ */
+static void ssd_lat_hist_printstats (int *set, int setsize, char *prefix)
+{
+   ssd_lat_stat l;
+   int i;
+
+   memset(&l, 0, sizeof(l));
+   for (i=0; i<setsize; i++) {
+      ssd_lat_stat_merge(&l, &getssd (set[i])->stat.lat);
+   }
+
+   ssd_hist_print_header(prefix, "Latency histograms");
+   ssd_lat_stat_print(&l, prefix);
+}
+
+// and those of each element of an ssd
+static void ssd_elem_lat_printstats (ssd_t *currdisk, char *prefix)
+{
+   char pprefix[100];
+   ssd_lat_stat *l;
+   int j;
+
+   ssd_hist_print_header(prefix, "Element latency histograms");
+   for (j=0; j<currdisk->params.nelements; j++) {
+      l = currdisk->elements[j].lat;
+      if (l->read.count + l->write.count + l->gc.count == 0) {
+         continue;
+      }
+      sprintf_s5(pprefix, 100, "%selem #%d ", prefix, j);
+      ssd_lat_stat_print(l, pprefix);
+   }
+}
+
+/*
+ * prints the response time of the reads and writes and each of its
+ * phases.
+ */
+static void ssd_lat_printstats (int *set, int setsize, char *prefix)
+{
+   static char *rw_names[2] = { "Read", "Write" };
+   char name[80];
+   ssd_hist h;
+   int i, j, rw;
+
+   for (i=0; i<setsize; i++) {
+      if (getssd (set[i])->params.latency_breakdown) {
+         break;
+      }
+   }
+   if (i == setsize) {
+      return;
+   }
+
+   ssd_hist_print_header(prefix, "Latency breakdown");
+   for (rw=0; rw<2; rw++) {
+      memset(&h, 0, sizeof(h));
+      for (i=0; i<setsize; i++) {
+         if (rw == SSD_LAT_READ) {
+            ssd_hist_merge(&h, &getssd (set[i])->stat.lat.read);
+         } else {
+            ssd_hist_merge(&h, &getssd (set[i])->stat.lat.write);
+         }
+      }
+      if (h.count == 0) {
+         continue;
+      }
+      sprintf_s4(name, 80, "%s response time", rw_names[rw]);
+      ssd_hist_print(&h, prefix, name);
+
+      for (j=0; j<SSD_LAT_PHASES; j++) {
+         memset(&h, 0, sizeof(h));
+         for (i=0; i<setsize; i++) {
+            ssd_hist_merge(&h, &getssd (set[i])->stat.lat_phase[rw][j]);
+         }
+         sprintf_s5(name, 80, "%s %s time", rw_names[rw], ssd_lat_phase_names[j]);
+         ssd_hist_print(&h, prefix, name);
+      }
+   }
+}
+
+static char *ssd_prof_names[SSD_PROF_ENTRIES] = {
+   "DEVICE_OVERHEAD_COMPLETE", "DEVICE_ACCESS_COMPLETE", "DEVICE_DATA_TRANSFER_COMPLETE",
+   "IO_INTERRUPT_COMPLETE", "SSD_ACTIVATE_ELEM", "SSD_CLEAN_GANG", "SSD_CLEAN_ELEMENT",
+   "SSD_CLEAN_LOG", "ssd_compute_access_time", "ssd_clean_*", "ssd_dpower"
+};
+
+/*
+ * prints where the wall clock time of the simulator went: the events
+ * handled and the ftl entry points called, with their total and per call
+ * times, and the number of events handled per second of the run.
+ */
+static void ssd_prof_printstats (int *set, int setsize, char *prefix)
+{
+   long long count[SSD_PROF_ENTRIES];
+   double wall[SSD_PROF_ENTRIES];
+   long long events = 0;
+   double handled = 0;
+   double start = 0;
+   double elapsed;
+   int profiled = 0;
+   int i, j;
+
+   memset(count, 0, sizeof(count));
+   memset(wall, 0, sizeof(wall));
+   for (i=0; i<setsize; i++) {
+      ssd_t *currdisk = getssd (set[i]);
+      if (!currdisk->params.self_profiling) {
+         continue;
+      }
+      if ((!profiled) || (start > currdisk->prof.start)) {
+         start = currdisk->prof.start;
+      }
+      profiled = 1;
+      for (j=0; j<SSD_PROF_ENTRIES; j++) {
+         count[j] += currdisk->prof.count[j];
+         wall[j] += currdisk->prof.wall[j];
+      }
+   }
+   if (!profiled) {
+      return;
+   }
+
+   for (j=0; j<SSD_PROF_EVENTS; j++) {
+      events += count[j];
+      handled += wall[j];
+   }
+   elapsed = ssd_wall_time() - start;
+
+   fprintf(outputfile, "%sSimulator profile:\tcount\twall time (s)\tus per call\n", prefix);
+   for (j=0; j<SSD_PROF_ENTRIES; j++) {
+      if (count[j] == 0) {
+         continue;
+      }
+      fprintf(outputfile, "%s%s %s:\t%lld\t%f\t%f\n", prefix, (j < SSD_PROF_EVENTS) ? "Event" : "Call",
+         ssd_prof_names[j], count[j], wall[j], wall[j] * 1000000 / count[j]);
+   }
+   fprintf(outputfile, "%sEvents handled:\t%lld\n", prefix, events);
+   fprintf(outputfile, "%sWall time in the events (s):\t%f\n", prefix, handled);
+   fprintf(outputfile, "%sWall time of the run (s):\t%f\n", prefix, elapsed);
+   if (elapsed > 0) {
+      fprintf(outputfile, "%sEvents per second:\t%f\n", prefix, events / elapsed);
+   }
 }
 
 static void ssd_print_block_lifetime_distribution(int elem_num, ssd_t *s, int ssdno, double avg_lifetime, char *sourcestr)
@@ -58,9 +309,10 @@ static void ssd_print_block_lifetime_distribution(int elem_num, ssd_t *s, int ss
     hist = (int *) malloc(no_buckets * sizeof(int));
     memset(hist, 0, no_buckets * sizeof(int));
 
-    // to calc the variance
+    // to calc the variance. the remaining life times vary just as much
+    // as the erasure counts, whose sums are kept as the blocks are erased.
     n = s->params.blocks_per_element;
-    variance_sqr = 0;
+    variance_sqr = metadata->tot_erasures_sqr - ((double)metadata->tot_erasures * metadata->tot_erasures) / n;
 
     for (i = 0; i < s->params.blocks_per_element; i ++) {
         int bucket;
@@ -83,9 +335,6 @@ static void ssd_print_block_lifetime_distribution(int elem_num, ssd_t *s, int ss
         }
 
         hist[bucket] ++;
-
-        // calculate the variance
-        variance_sqr = variance_sqr + ((rem_lifetime - avg_lifetime) * (rem_lifetime - avg_lifetime));
     }
 
 
@@ -268,6 +517,50 @@ static void ssd_printcleanstats(int *set, int setsize, char *sourcestr)
 }
 
 //@20090831-Micky:print power consumptions of SSD
+/*
+ * prints the statistics of the exact power curve: the peak power and
+ * current, the 99th percentile of the power over time and the time
+ * spent above the power budget.
+ */
+static void ssd_power_profile_printstats(int *set, int setsize, char *sourcestr)
+{
+	int i, j;
+
+	for (i = 0; i < setsize; i ++) {
+		ssd_t *s = getssd(set[i]);
+		ssd_power_profile *p = s->power_profile;
+		double acc = 0.0;
+		double p99 = 0.0;
+
+		if (p == NULL) {
+			continue;
+		}
+		ssd_power_profile_finish(s);
+
+		// the percentile is taken at the upper end of its bin
+		for (j = 0; j < SSD_POWER_PROFILE_BINS; j ++) {
+			acc += p->hist[j];
+			if (acc >= p->tot_time * 0.99) {
+				p99 = (j + 1) * p->bin_width;
+				break;
+			}
+		}
+
+		fprintf(outputfile, "%s #%d Peak power:\t%f mW - time:%f\n",
+			sourcestr, set[i], p->peak_power * 1000, p->peak_time);
+		fprintf(outputfile, "%s #%d Peak current:\t%f mA\n",
+			sourcestr, set[i], p->peak_current * 1000);
+		fprintf(outputfile, "%s #%d 99th percentile power:\t%f mW\n",
+			sourcestr, set[i], p99 * 1000);
+		if (s->params.power_budget > 0) {
+			fprintf(outputfile, "%s #%d Time above power budget:\t%f (%.2f%%) - budget:%f mW\n",
+				sourcestr, set[i], p->over_budget,
+				(p->tot_time > 0) ? (p->over_budget / p->tot_time * 100.0) : 0.0, s->params.power_budget);
+		}
+		fprintf(outputfile, "\n");
+	}
+}
+
 static void ssd_power_printstats(int *set, int setsize, char *sourcestr)
 {
 	int i;
@@ -335,7 +628,8 @@ static void ssd_power_printstats(int *set, int setsize, char *sourcestr)
 		// get RAM energy
 		//total_energy += s->params.dram_input_voltage * s->params.dram_active_current * cpu_idle_time;
 		//total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * ssd_runoutstanding;
-		total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * simtime;
+		total_energy += s->ssd_power_stat.dram_power_consumed;
+		total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * (simtime - s->ssd_power_stat.dram_time_consumed);
 
 		// get Leakage energy
 		leakage_energy = s->params.leakage_power * simtime;
@@ -424,13 +718,17 @@ static void ssd_power_printstats(int *set, int setsize, char *sourcestr)
 
 		{
 			//double ram_total_energy = (s->params.dram_input_voltage * s->params.dram_active_current * cpu_idle_time) + (s->params.dram_input_voltage * s->params.dram_idle_current * ssd_runoutstanding);
-			double ram_total_energy = s->params.dram_input_voltage * s->params.dram_idle_current * simtime;
+			double ram_idle_time = simtime - s->ssd_power_stat.dram_time_consumed;
+			double ram_total_energy;
+			ram_active_energy = s->ssd_power_stat.dram_power_consumed;
+			ram_idle_energy = s->params.dram_input_voltage * s->params.dram_idle_current * ram_idle_time;
+			ram_total_energy = ram_active_energy + ram_idle_energy;
 			fprintf(outputfile, "%s #%d RAM: Total energy used:\t%f mJ (%.2f%%)\n",
 				sourcestr, set[i], ram_total_energy, (ram_total_energy / total_energy * 100.0));
 			fprintf(outputfile, "%s #%d RAM:     Active energy:\t%f mJ (%.2f%%) - time taken: %f\n",
-				sourcestr, set[i], (s->params.dram_input_voltage * s->params.dram_active_current * 0), 0.0, 0.0);
+				sourcestr, set[i], ram_active_energy, (ram_active_energy / ram_total_energy * 100.0), s->ssd_power_stat.dram_time_consumed);
 			fprintf(outputfile, "%s #%d RAM:     Idle energy:\t%f mJ (%.2f%%) - time taken: %f\n",
-				sourcestr, set[i], (s->params.dram_input_voltage * s->params.dram_idle_current * simtime), 100.0, simtime);
+				sourcestr, set[i], ram_idle_energy, (ram_idle_energy / ram_total_energy * 100.0), ram_idle_time);
 			fprintf(outputfile, "\n");
 		}
 
@@ -518,7 +816,8 @@ static void ssd_power_printstats(int *set, int setsize, char *sourcestr)
 		// get RAM energy
 		//total_energy += s->params.dram_input_voltage * s->params.dram_active_current * cpu_idle_time;
 		//total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * ssd_runoutstanding;
-		total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * simtime;
+		total_energy += s->ssd_power_stat.dram_power_consumed;
+		total_energy += s->params.dram_input_voltage * s->params.dram_idle_current * (simtime - s->ssd_power_stat.dram_time_consumed);
 
 		// get Leakage energy
 		leakage_energy = s->params.leakage_power * simtime;
@@ -611,13 +910,17 @@ static void ssd_power_printstats(int *set, int setsize, char *sourcestr)
 
 		{
 			//double ram_total_energy = (s->params.dram_input_voltage * s->params.dram_active_current * cpu_idle_time) + (s->params.dram_input_voltage * s->params.dram_idle_current * ssd_runoutstanding);
-			double ram_total_energy = s->params.dram_input_voltage * s->params.dram_idle_current * simtime;
+			double ram_idle_time = simtime - s->ssd_power_stat.dram_time_consumed;
+			double ram_total_energy;
+			ram_active_energy = s->ssd_power_stat.dram_power_consumed;
+			ram_idle_energy = s->params.dram_input_voltage * s->params.dram_idle_current * ram_idle_time;
+			ram_total_energy = ram_active_energy + ram_idle_energy;
 			fprintf(outputfile, "%s #%d RAM: Total energy used:\t%f mJ (%.2f%%)\n",
 				sourcestr, set[i], ram_total_energy, (ram_total_energy / total_energy * 100.0));
 			fprintf(outputfile, "%s #%d RAM:     Active energy:\t%f mJ (%.2f%%) - time taken: %f\n",
-				sourcestr, set[i], (s->params.dram_input_voltage * s->params.dram_active_current * 0), 0.0, 0.0);
+				sourcestr, set[i], ram_active_energy, (ram_active_energy / ram_total_energy * 100.0), s->ssd_power_stat.dram_time_consumed);
 			fprintf(outputfile, "%s #%d RAM:     Idle energy:\t%f mJ (%.2f%%) - time taken: %f\n",
-				sourcestr, set[i], (s->params.dram_input_voltage * s->params.dram_idle_current * simtime), 100.0, simtime);
+				sourcestr, set[i], ram_idle_energy, (ram_idle_energy / ram_total_energy * 100.0), ram_idle_time);
 			fprintf(outputfile, "\n");
 		}
 
@@ -690,6 +993,7 @@ void ssd_printstats (void)
 
    if (reqcnt == 0) {
       fprintf(outputfile, "No ssd requests encountered\n");
+      ssd_trace_flush_all();
       return;
    }
 
@@ -710,13 +1014,27 @@ void ssd_printstats (void)
 	// temp : micky
 	ssd_acctime_printstats(set, numssds, prefix);
 	ssd_other_printstats(set, numssds, prefix);
+	ssd_cache_printstats(set, numssds, prefix);
+	ssd_lat_hist_printstats(set, numssds, prefix);
+	ssd_lat_printstats(set, numssds, prefix);
 	//--
 	
    ssd_printcleanstats(set, numssds, prefix);
 
 	//@20090831-Micky:print power consumptions of SSD
 	fprintf (outputfile, "\n\n");
+	for (i = 0; i < numssds; i ++) {
+		// the sampled power timeline is written up to the end of the run
+		ssd_power_sampler_finish(getssd(set[i]));
+	}
 	ssd_power_printstats(set, numssds, prefix);
+	ssd_power_profile_printstats(set, numssds, prefix);
+
+	// the traces are complete now, write them out before disksim
+	// closes their files
+	ssd_trace_flush_all();
+
+	ssd_prof_printstats(set, numssds, prefix);
 	//--
 
    fprintf (outputfile, "\n\n");
@@ -751,6 +1069,10 @@ void ssd_printstats (void)
       }
       ssd_acctime_printstats(&set[i], 1, prefix);
       ssd_other_printstats(&set[i], 1, prefix);
+      ssd_cache_printstats(&set[i], 1, prefix);
+      ssd_lat_hist_printstats(&set[i], 1, prefix);
+      ssd_elem_lat_printstats(currdisk, prefix);
+      ssd_lat_printstats(&set[i], 1, prefix);
       fprintf (outputfile, "\n\n");
    }
 
@@ -782,6 +1104,9 @@ void ssd_printsetstats (int *set, int setsize, char *sourcestr)
 
    ssd_acctime_printstats(set, setsize, prefix);
    ssd_other_printstats(set, setsize, prefix);
+   ssd_cache_printstats(set, setsize, prefix);
+   ssd_lat_hist_printstats(set, setsize, prefix);
+   ssd_lat_printstats(set, setsize, prefix);
 }
 
 
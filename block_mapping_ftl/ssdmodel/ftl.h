@@ -35,6 +35,7 @@ void ssd_compute_access_time(ssd_t *s, int elem_num, ssd_req **reqs, int total);
 // for Cleaning
 int ssd_clean_element(ssd_t *s, int elem_num);
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s);
+void ssd_victim_index_init(ssd_element_metadata *metadata, ssd_t *s);
 void ssd_activate_elem(ssd_t *currdisk, int elem_num);
 int ssd_lpn_to_blkno(int lpn, ssd_t *s);
 
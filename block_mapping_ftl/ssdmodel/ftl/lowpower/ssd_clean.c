@@ -46,6 +46,120 @@ static double ssd_crossover_cost
     }
 }
 
+/*
+ * victim index: every sealed block of a plane is linked on one of the
+ * plane's victim lists according to its num of valid pages. this lets
+ * the greedy cleaner find the blocks to clean without scanning the
+ * whole element. the lists are updated whenever a block gets sealed,
+ * loses a valid page or gets erased.
+ */
+static void ssd_victim_index_unlink(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+    plane_metadata *pm = &metadata->plane_meta[bm->plane_num];
+
+    if (bm->victim_prev != -1) {
+        metadata->block_usage[bm->victim_prev].victim_next = bm->victim_next;
+    } else {
+        ASSERT(pm->victim_list[bm->victim_bucket] == blk);
+        pm->victim_list[bm->victim_bucket] = bm->victim_next;
+    }
+
+    if (bm->victim_next != -1) {
+        metadata->block_usage[bm->victim_next].victim_prev = bm->victim_prev;
+    }
+
+    bm->victim_bucket = -1;
+    bm->victim_prev = -1;
+    bm->victim_next = -1;
+}
+
+static void ssd_victim_index_link(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+    plane_metadata *pm = &metadata->plane_meta[bm->plane_num];
+    int bucket = bm->num_valid;
+
+    bm->victim_bucket = bucket;
+    bm->victim_prev = -1;
+    bm->victim_next = pm->victim_list[bucket];
+    if (bm->victim_next != -1) {
+        metadata->block_usage[bm->victim_next].victim_prev = blk;
+    }
+    pm->victim_list[bucket] = blk;
+}
+
+/*
+ * moves an indexed block to the list matching its current num of valid pages.
+ */
+void ssd_victim_index_update(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+
+    if ((bm->victim_bucket != -1) && (bm->victim_bucket != bm->num_valid)) {
+        ssd_victim_index_unlink(blk, metadata);
+        ssd_victim_index_link(blk, metadata);
+    }
+}
+
+/*
+ * adds a block that just got sealed to the victim index. the erase of a
+ * sealed block is only queued, so a block can get sealed again before it
+ * is erased. such a block is just moved to its current list.
+ */
+void ssd_victim_index_insert(int blk, ssd_element_metadata *metadata)
+{
+    if (metadata->block_usage[blk].victim_bucket != -1) {
+        ssd_victim_index_update(blk, metadata);
+    } else {
+        ssd_victim_index_link(blk, metadata);
+    }
+}
+
+/*
+ * removes a block from the victim index (when it is erased).
+ */
+void ssd_victim_index_remove(int blk, ssd_element_metadata *metadata)
+{
+    if (metadata->block_usage[blk].victim_bucket != -1) {
+        ssd_victim_index_unlink(blk, metadata);
+    }
+}
+
+/*
+ * allocates the victim lists of an element and indexes all the blocks
+ * that are already sealed.
+ */
+void ssd_victim_index_init(ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        if (!(pm->victim_list = (int *)malloc(sizeof(int) * (s->params.pages_per_block + 1)))) {
+            fprintf(stderr, "Error: malloc to victim_list in ssd_victim_index_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(int) * (s->params.pages_per_block + 1));
+            exit(1);
+        }
+
+        for (j = 0; j <= s->params.pages_per_block; j ++) {
+            pm->victim_list[j] = -1;
+        }
+    }
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        metadata->block_usage[i].victim_bucket = -1;
+        metadata->block_usage[i].victim_prev = -1;
+        metadata->block_usage[i].victim_next = -1;
+
+        if (ssd_can_clean_block(s, metadata, i)) {
+            ssd_victim_index_insert(i, metadata);
+        }
+    }
+}
+
 //* writes a page to the current active page. if there is no active page,
 // * allocate one and then move.
 
@@ -155,9 +269,17 @@ void ssd_clean_one_block
  */
 void ssd_update_block_lifetime(double time, int blk, ssd_element_metadata *metadata)
 {
+    long long erasures = SSD_MAX_ERASURES - metadata->block_usage[blk].rem_lifetime;
+
     metadata->block_usage[blk].rem_lifetime --;
     metadata->block_usage[blk].time_of_last_erasure = time;
 
+    // update the running wear statistics. the square of the
+    // block's erasure count grows from e^2 to (e+1)^2.
+    metadata->plane_meta[metadata->block_usage[blk].plane_num].tot_erasures ++;
+    metadata->tot_erasures ++;
+    metadata->tot_erasures_sqr += 2 * erasures + 1;
+
     if (metadata->block_usage[blk].rem_lifetime < 0) {
         fprintf(stderr, "Error: Negative lifetime %d (block is being erased after it's dead)\n",
             metadata->block_usage[blk].rem_lifetime);
@@ -179,6 +301,7 @@ void ssd_update_free_block_status(int blk, int plane_num, ssd_element_metadata *
     ssd_clear_bit(metadata->free_blocks, bitpos);
     metadata->block_usage[blk].state = SSD_BLOCK_CLEAN;
     metadata->block_usage[blk].bsn = 0;
+    ssd_victim_index_remove(blk, metadata);
     metadata->tot_free_blocks ++;
     metadata->plane_meta[plane_num].free_blocks ++;
     ssd_assert_free_blocks(s, metadata);
@@ -233,22 +356,14 @@ int ssd_rate_limit(int block_life, double avg_lifetime)
 
 /*
  * computes the average lifetime of all the blocks in a plane.
+ * the average remaining life time is the max num of erasures less
+ * the average num of erasures performed on the blocks so far.
  */
 double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
 {
-    int i;
-    int bitpos;
-    double tot_lifetime = 0;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    bitpos = plane_num * s->params.blocks_per_plane;
-    for (i = bitpos; i < bitpos + (int)s->params.blocks_per_plane; i ++) {
-        int block = ssd_bitpos_to_block(i, s);
-        ASSERT(metadata->block_usage[block].plane_num == plane_num);
-        tot_lifetime += metadata->block_usage[block].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_plane);
+    return (SSD_MAX_ERASURES - ((double)metadata->plane_meta[plane_num].tot_erasures / s->params.blocks_per_plane));
 }
 
 
@@ -257,15 +372,9 @@ double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
  */
 double ssd_compute_avg_lifetime_in_element(int elem_num, ssd_t *s)
 {
-    double tot_lifetime = 0;
-    int i;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        tot_lifetime += metadata->block_usage[i].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_element);
+    return (SSD_MAX_ERASURES - ((double)metadata->tot_erasures / s->params.blocks_per_element));
 }
 
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s)
@@ -474,6 +583,14 @@ int ssd_migrate_cold_data(int to_blk, int plane_num, int elem_num, ssd_t *s)
     }
     metadata->block_usage[to_blk].state = metadata->block_usage[from_blk].state;
 
+    // the erase of to_blk is only queued, so it is still indexed. it now
+    // holds the cold data and from_blk is left with no valid pages.
+    ssd_victim_index_remove(to_blk, metadata);
+    if (metadata->block_usage[to_blk].state == SSD_BLOCK_SEALED) {
+        ssd_victim_index_insert(to_blk, metadata);
+    }
+    ssd_victim_index_update(from_blk, metadata);
+
     bitpos = ssd_block_to_bitpos(s, to_blk);
     ssd_set_bit(metadata->free_blocks, bitpos);
     metadata->tot_free_blocks --;
@@ -531,77 +648,65 @@ int ssd_pick_wear_aware_with_migration
 
 /*
  * a greedy solution, where we find the block in a plane with the least
- * num of valid pages and return it.
+ * num of valid pages and return it. only the blocks without valid pages
+ * can be cleaned, so the candidates are taken from the first victim list
+ * of each plane.
  */
 static int ssd_pick_block_to_clean2(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
     double avg_lifetime = 1;
-    int i;
-    int size;
+    int p;
     int block = -1;
-    listnode *greedy_list;
+    int first = -1;
 
     // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    // we create a list of greedily selected blocks
-    ll_create(&greedy_list);
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-			ASSERT(i == metadata->block_usage[i].block_num);
-			ll_insert_at_head(greedy_list, (void*)&metadata->block_usage[i]);
-			block = i;
-        }
+    if (s->params.cleaning_policy != DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
+        avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
     }
 
-    ASSERT(block != -1);
-    block = -1;
+    for (p = 0; p < s->params.planes_per_pkg; p ++) {
+        int blk;
 
-    // from the greedily picked blocks, select one after rate
-    // limiting the overly used blocks
-    size = ll_get_size(greedy_list);
+        if ((plane_num != -1) && (p != plane_num)) {
+            continue;
+        }
 
-    //printf("plane %d elem %d size %d avg lifetime %f\n",
-    //  plane_num, elem_num, size, avg_lifetime);
+        for (blk = metadata->plane_meta[p].victim_list[0]; blk != -1; blk = metadata->block_usage[blk].victim_next) {
+            block_metadata *bm = &metadata->block_usage[blk];
+            int mig_blk;
 
-    for (i = 0; i < size; i ++) {
-        block_metadata *bm;
-        int mig_blk;
+            if (!_ssd_pick_block_to_clean(blk, plane_num, elem_num, metadata, s)) {
+                continue;
+            }
 
-        listnode *n = ll_get_nth_node(greedy_list, i);
-        bm = ((block_metadata *)n->data);
+            if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
+                return blk;
+            }
 
-        // this is the last of the greedily picked blocks.
-        if (i == size -1) {
-            // select it!
-            block = bm->block_num;
-            break;
-        }
+            // remember the first candidate in case every
+            // candidate gets rate limited
+            if (first == -1) {
+                first = blk;
+            }
 
-        if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
-            block = bm->block_num;
-            break;
-        } else {
 #if MIGRATE
             // migration
-            mig_blk = ssd_pick_wear_aware_with_migration(bm->block_num, bm->rem_lifetime, avg_lifetime, bm->plane_num, elem_num, s);
-            if (mig_blk != bm->block_num) {
+            mig_blk = ssd_pick_wear_aware_with_migration(blk, bm->rem_lifetime, avg_lifetime, bm->plane_num, elem_num, s);
+            if (mig_blk != blk) {
                 // data has been migrated and we have a new
                 // block to use
-                block = mig_blk;
-                break;
+                return mig_blk;
             }
 #endif
 
             // pick this block giving consideration to its life time
-            if (ssd_pick_wear_aware(bm->block_num, bm->rem_lifetime, avg_lifetime, s)) {
-                block = bm->block_num;
-                break;
+            if (ssd_pick_wear_aware(blk, bm->rem_lifetime, avg_lifetime, s)) {
+                return blk;
             }
         }
     }
 
-    ll_release(greedy_list);
+    block = first;
 
     ASSERT(block != -1);
     return block;
@@ -609,26 +714,25 @@ static int ssd_pick_block_to_clean2(int plane_num, int elem_num, ssd_element_met
 
 static int ssd_pick_block_to_clean1(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
-    int i;
-    int block = -1;
-    int min_valid = s->params.pages_per_block - 1; // one page goes for the summary info
+    int p;
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-            if (metadata->block_usage[i].num_valid < min_valid) {
-                min_valid = metadata->block_usage[i].num_valid;
-                block = i;
+    for (p = 0; p < s->params.planes_per_pkg; p ++) {
+        int blk;
+
+        if ((plane_num != -1) && (p != plane_num)) {
+            continue;
+        }
+
+        for (blk = metadata->plane_meta[p].victim_list[0]; blk != -1; blk = metadata->block_usage[blk].victim_next) {
+            if (_ssd_pick_block_to_clean(blk, plane_num, elem_num, metadata, s)) {
+                return blk;
             }
         }
     }
 
-    if (block != -1) {
-        return block;
-    } else {
-        fprintf(stderr, "Error: we cannot find a block to clean in plane %d\n", plane_num);
-        ASSERT(0);
-        exit(1);
-    }
+    fprintf(stderr, "Error: we cannot find a block to clean in plane %d\n", plane_num);
+    ASSERT(0);
+    exit(1);
 }
 
 static int ssd_pick_block_to_clean(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
@@ -674,54 +778,6 @@ static void ssd_clean_block_fully(int plane_num, int elem_num, ssd_t *s)
 }
 
 
-static usage_table *ssd_build_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        int usage = metadata->block_usage[i].num_valid;
-        table[usage].len ++;
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        usage_table *entry;
-        int usage = metadata->block_usage[i].num_valid;
-
-        entry = &(table[usage]);
-        entry->block[entry->temp ++] = i;
-    }
-
-    return table;
-}
-
-static void ssd_release_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
 /*
  * pick a random block with at least 1 empty page slot and clean it
  */
@@ -775,87 +831,81 @@ static double ssd_clean_blocks_random(int plane_num, int elem_num, ssd_t *s)
 #define GREEDY_IN_COPYBACK 0
 
 /*
- * first we create a hash table of blocks according to their
- * usage. then we select blocks with the least usage and clean
- * them.
+ * the victim index already keeps the sealed blocks bucketed by their
+ * usage. only the blocks without valid pages can be cleaned, so we walk
+ * the first list of each plane and clean them.
  */
 static int ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
 {
     double avg_lifetime;
-    int i;
-    usage_table *table;
-	usage_table *entry;
+    int p;
 	int clean_invoked = 0;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    /////////////////////////////////////////////////////////////////////////////
-    // build the histogram
-    table = ssd_build_usage_table(elem_num, s);
-
     //////////////////////////////////////////////////////////////////////////////
     // find the average life time of all the blocks in this element
     avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
 
-    /////////////////////////////////////////////////////////////////////////////
-    // we now have a hash table of blocks, where the key of each
-    // bucket is the usage count and each bucket has all the blocks with
-    // the same usage count (i.e., the same num of valid pages).
-
-	// get the bucket of blocks with 'i' valid pages
-	entry = &(table[0]);
-
-	// free all the blocks with 'i' valid pages
-	for (i = 0; i < entry->len; i ++) {
-		int blk = entry->block[i];
-		int block_life = metadata->block_usage[blk].rem_lifetime;
+	for (p = 0; p < s->params.planes_per_pkg; p ++) {
+		int blk;
+		int next;
 
 		// if this is plane specific cleaning, then skip all the
 		// blocks that don't belong to this plane.
-		if ((plane_num != -1) && (metadata->block_usage[blk].plane_num != plane_num)) {
-			continue;
-		}
-
-		// if the block is already dead, skip it
-		if (block_life == 0) {
+		if ((plane_num != -1) && (p != plane_num)) {
 			continue;
 		}
 
-		// clean only those blocks that are sealed.
-		if (ssd_can_clean_block(s, metadata, blk)) {
+		// free all the blocks with no valid pages. the erase is only
+		// queued, so the block stays linked until it is erased.
+		for (blk = metadata->plane_meta[p].victim_list[0]; blk != -1; blk = next) {
+			int block_life = metadata->block_usage[blk].rem_lifetime;
 
-			// if we care about wear-leveling, then we must rate limit overly cleaned blocks
-			if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
+			next = metadata->block_usage[blk].victim_next;
 
-				// see if this block's remaining lifetime is within
-				// a certain threshold of the average remaining lifetime
-				// of all blocks in this element
-				if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
-					// we have to rate limit this block as it has exceeded
-					// its cleaning limits
-					printf("Rate limiting block %d (block life %d avg life %f\n",
-						blk, block_life, avg_lifetime);
+			// if the block is already dead, skip it
+			if (block_life == 0) {
+				continue;
+			}
 
-					if (ssd_rate_limit(block_life, avg_lifetime)) {
-						// skip this block and go to the next on
-						continue;
+			// clean only those blocks that are sealed.
+			if (ssd_can_clean_block(s, metadata, blk)) {
+
+				// if we care about wear-leveling, then we must rate limit overly cleaned blocks
+				if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
+
+					// see if this block's remaining lifetime is within
+					// a certain threshold of the average remaining lifetime
+					// of all blocks in this element
+					if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
+						// we have to rate limit this block as it has exceeded
+						// its cleaning limits
+						printf("Rate limiting block %d (block life %d avg life %f\n",
+							blk, block_life, avg_lifetime);
+
+						if (ssd_rate_limit(block_life, avg_lifetime)) {
+							// skip this block and go to the next on
+							continue;
+						}
 					}
 				}
-			}
 
-			// okies, finally here we're with the block to be cleaned.
-			// invoke cleaning until we reach the high watermark.
-			_ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
-			clean_invoked = 1;
+				// okies, finally here we're with the block to be cleaned.
+				// invoke cleaning until we reach the high watermark.
+				_ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
+				clean_invoked = 1;
 
-			if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-				// no more cleaning is required -- so quit.
-				break;
+				if (ssd_stop_cleaning(plane_num, elem_num, s)) {
+					// no more cleaning is required -- so quit.
+					break;
+				}
 			}
 		}
-	}
 
-    // release the table
-    ssd_release_usage_table(table, s);
+		if (ssd_stop_cleaning(plane_num, elem_num, s)) {
+			break;
+		}
+	}
 
     // see if we were able to generate enough free blocks
     if (!ssd_stop_cleaning(plane_num, elem_num, s)) {
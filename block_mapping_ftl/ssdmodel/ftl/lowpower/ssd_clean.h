@@ -31,17 +31,14 @@
 #endif
 
 
-typedef struct _usage_table {
-    int len;
-    int temp;
-    int *block;
-} usage_table;
-
-
 int ssd_clean_element_no_copyback(int elem_num, ssd_t *s);
 int ssd_free_bits(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s);
 void ssd_assert_plane_freebits(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s);
 
+void ssd_victim_index_insert(int blk, ssd_element_metadata *metadata);
+void ssd_victim_index_remove(int blk, ssd_element_metadata *metadata);
+void ssd_victim_index_update(int blk, ssd_element_metadata *metadata);
+
 void _ssd_clean_block_fully(int blk, int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s);
 
 int ssd_next_plane_in_parunit(int plane_num, int parunit_num, int elem_num, ssd_t *s);
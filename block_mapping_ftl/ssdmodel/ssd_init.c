@@ -5,6 +5,8 @@
 #include "ftl.h"
 #include "ssd_utils.h"
 #include "ssd_init.h"
+#include "ssd_chrome_trace.h"
+#include "ssd_cache.h"
 
 #include "modules/ssdmodel_ssd_param.h"
 
@@ -20,6 +22,7 @@ int ssd_get_maxoutstanding (int devno);
 static void ssd_statinit (int devno, int firsttime)
 {
    ssd_t *currdisk;
+   int i;
 
    currdisk = getssd (devno);
    if (firsttime) {
@@ -31,6 +34,28 @@ static void ssd_statinit (int devno, int firsttime)
    currdisk->stat.requestedbus = 0.0;
    currdisk->stat.waitingforbus = 0.0;
    currdisk->stat.numbuswaits = 0;
+   currdisk->stat.cache_read_hits = 0;
+   currdisk->stat.cache_read_misses = 0;
+   currdisk->stat.cache_write_hits = 0;
+   currdisk->stat.cache_write_misses = 0;
+   currdisk->stat.cache_destages = 0;
+   currdisk->stat.cache_pages_destaged = 0;
+   currdisk->stat.cache_prefetches = 0;
+   currdisk->stat.cache_prefetch_hits = 0;
+   currdisk->stat.cache_prefetch_wasted = 0;
+   currdisk->stat.activates_folded = 0;
+   currdisk->stat.max_completion_qlen = 0;
+   currdisk->stat.reqs_pooled = 0;
+   currdisk->stat.req_allocs = 0;
+   memset(currdisk->stat.lat_phase, 0, sizeof(currdisk->stat.lat_phase));
+   memset(&currdisk->stat.lat, 0, sizeof(currdisk->stat.lat));
+
+   // the histograms of the elements are only allocated after the first call
+   for (i=0; i<currdisk->params.nelements; i++) {
+      if (currdisk->elements[i].lat != NULL) {
+         memset(currdisk->elements[i].lat, 0, sizeof(ssd_lat_stat));
+      }
+   }
 }
 
 void ssd_event_arrive (ioreq_event *curr)
@@ -103,7 +128,6 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
     gang_metadata *g;
     unsigned int ppage;
     unsigned int i;
-    unsigned int bytes_to_alloc;
     unsigned int tot_blocks = currdisk->params.blocks_per_element;
     unsigned int tot_pages = tot_blocks * currdisk->params.pages_per_block;
     unsigned int reserved_blocks, usable_blocks, export_size;
@@ -142,6 +166,8 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
     metadata->tot_migrations = 0;
     metadata->tot_pgs_migrated = 0;
     metadata->mig_cost = 0;
+    metadata->tot_erasures = 0;
+    metadata->tot_erasures_sqr = 0;
 
     //////////////////////////////////////////////////////////////////////////////
     // init the plane metadata
@@ -174,12 +200,21 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
         metadata->plane_meta[i].block_alloc_pos = i*currdisk->params.blocks_per_plane;
         metadata->plane_meta[i].parunit_num = i / SSD_PLANES_PER_PARUNIT(currdisk);
         metadata->plane_meta[i].num_cleans = 0;
+        metadata->plane_meta[i].tot_erasures = 0;
     }
 
     //////////////////////////////////////////////////////////////////////////////
     // init the next plane to clean in a parunit
     for (i = 0; i < (unsigned int) SSD_PARUNITS_PER_ELEM(currdisk); i ++) {
         metadata->parunits[i].plane_to_clean = SSD_PLANES_PER_PARUNIT(currdisk)*i;
+
+        if (!(metadata->parunits[i].ring = (ssd_req **)malloc(sizeof(ssd_req *) * MAX_REQS_ELEM_QUEUE))) {
+            fprintf(stderr, "Error: malloc to parunit ring in ssd_element_metadata_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_req *) * MAX_REQS_ELEM_QUEUE);
+            exit(1);
+        }
+        metadata->parunits[i].ring_head = 0;
+        metadata->parunits[i].ring_count = 0;
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -222,19 +257,7 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
 
     //////////////////////////////////////////////////////////////////////////////
     // allocate the free blocks bit map
-    // what if the no of blocks is not divisible by 8?
-    if ((tot_blocks % (sizeof(unsigned char) * 8)) != 0) {
-        fprintf(stderr, "This case is not yet handled\n");
-        exit(1);
-    }
-
-    bytes_to_alloc = tot_blocks / (sizeof(unsigned char) * 8);
-    if (!(metadata->free_blocks = (unsigned char *)malloc(bytes_to_alloc))) {
-        fprintf(stderr, "Error: malloc to free_blocks in ssd_element_metadata_init failed\n");
-        fprintf(stderr, "Allocation size = %d\n", bytes_to_alloc);
-        exit(1);
-    }
-    bzero(metadata->free_blocks, bytes_to_alloc);
+    metadata->free_blocks = ssd_bitmap_alloc(tot_blocks);
 
     //////////////////////////////////////////////////////////////////////////////
     // allocate the block usage array and initialize it
@@ -245,18 +268,17 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
     }
     bzero(metadata->block_usage, tot_blocks * sizeof(block_metadata));
 
-    for (i = 0; i < tot_blocks; i ++) {
-        int j;
+    // the page entries of all the blocks are kept in one table
+    if (!(metadata->page_table = (int *)malloc(tot_blocks * currdisk->params.pages_per_block * sizeof(int)))) {
+        fprintf(stderr, "Error: malloc to page_table in ssd_element_metadata_init failed\n");
+        fprintf(stderr, "Allocation size = %d\n", tot_blocks * currdisk->params.pages_per_block * sizeof(int));
+        exit(1);
+    }
+    memset(metadata->page_table, -1, tot_blocks * currdisk->params.pages_per_block * sizeof(int));
 
+    for (i = 0; i < tot_blocks; i ++) {
         metadata->block_usage[i].block_num = i;
-        metadata->block_usage[i].page = (int*)malloc(sizeof(int) * currdisk->params.pages_per_block);
-		if(metadata->block_usage[i].page == NULL){
-			printf("malloc alloc fail\n");
-		}
-
-        for (j = 0; j < currdisk->params.pages_per_block; j ++) {
-            metadata->block_usage[i].page[j] = -1;
-        }
+        metadata->block_usage[i].page = &metadata->page_table[i * currdisk->params.pages_per_block];
 
         // assign the plane number to each block
         switch(plane_block_mapping) {
@@ -416,6 +438,10 @@ void ssd_element_metadata_init(int elem_number, ssd_element_metadata *metadata,
     // set the bsn for the ssd element
     metadata->bsn = bsn;
     //printf("set the bsn to %d\n", bsn);
+
+    //////////////////////////////////////////////////////////////////////////////
+    // index the sealed blocks for cleaning
+    ssd_victim_index_init(metadata, currdisk);
 }
 
 void ssd_plane_init(ssd_element *elem, ssd_t *s, int devno)
@@ -566,6 +592,8 @@ void ssd_initialize (void)
          addlisttoextraq ((event **) &currdisk->buswait);
          currdisk->busowned = -1;
          currdisk->completion_queue = NULL;
+         currdisk->completion_tail = NULL;
+         currdisk->completion_qlen = 0;
          /* hack to init queue structure */
          ioqueue_initialize (currdisk->queue, i);
          ssd_statinit(i, TRUE);
@@ -595,6 +623,7 @@ void ssd_initialize (void)
 
             // vp - pins are also free
             elem->pin_busy = FALSE;
+            elem->activate = NULL;
 
             // vp - initialize the planes in the element
             ssd_plane_init(elem, currdisk, i);
@@ -611,6 +640,25 @@ void ssd_initialize (void)
             //@20090831-Micky::add power consumption statistics
             memset(&elem->power_stat, 0, sizeof(ssd_power_element_stat));
          }
+
+         // latency histograms of the elements
+         ssd_lat_stat_init(currdisk);
+
+         // element and channel timelines for chrome://tracing
+         ssd_chrome_trace_init(currdisk);
+
+         // write-back buffer in the dram of the controller
+         ssd_cache_init(currdisk);
+
+         // the wall clock time of the run is measured from here
+         currdisk->prof.start = ssd_wall_time();
+
+         // preallocate the request objects and vectors used on activation
+         ssd_req_pool_init(currdisk);
+         ssd_dedup_init(currdisk);
+         // precompute the power of each operation type
+         ssd_power_init(currdisk);
+
 		 //tiel :: init channel flag
 		 for(j=0; j < MAX_CHANNEL ; j++){
 			 currdisk->CH[j].flag = -1;
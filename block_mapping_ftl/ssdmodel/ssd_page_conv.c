@@ -0,0 +1,52 @@
+
+/*
+ * converts a binary page trace written to outputfile4 or outputfile5
+ * into the "time lpn elem blkno" text lines.
+ *
+ * usage: ssd_page_conv <trace> [<text>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ssd_page_trace.h"
+
+int main(int argc, char **argv)
+{
+	FILE *in;
+	FILE *out = stdout;
+	ssd_page_record rec;
+
+	if ((argc != 2) && (argc != 3)) {
+		fprintf(stderr, "usage: %s <trace> [<text>]\n", argv[0]);
+		exit(1);
+	}
+
+	if ((in = fopen(argv[1], "rb")) == NULL) {
+		fprintf(stderr, "Error: cannot open %s\n", argv[1]);
+		exit(1);
+	}
+	if ((argc == 3) && ((out = fopen(argv[2], "w")) == NULL)) {
+		fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+		exit(1);
+	}
+
+	if (!ssd_trace_read_header(in, SSD_PAGE_TRACE_MAGIC, sizeof(ssd_page_record))) {
+		fprintf(stderr, "Error: %s is not a page trace\n", argv[1]);
+		exit(1);
+	}
+
+	while (fread(&rec, sizeof(rec), 1, in) == 1) {
+		if (rec.tag) {
+			fprintf(out, "%.6f %d %d %d %c\n", rec.time, rec.lpn, rec.elem_num, rec.blkno, rec.tag);
+		} else {
+			fprintf(out, "%10.6f %d %d %d\n", rec.time, rec.lpn, rec.elem_num, rec.blkno);
+		}
+	}
+
+	fclose(in);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,66 @@
+
+/*
+ * converts the binary power timeline written to outputfile2 into the
+ * "#SSD Power Distribution" csv.
+ *
+ * usage: ssd_power_conv <timeline> [<csv>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssd_power_trace.h"
+
+int main(int argc, char **argv)
+{
+	FILE *in;
+	FILE *out = stdout;
+	ssd_power_record rec;
+
+	if ((argc != 2) && (argc != 3)) {
+		fprintf(stderr, "usage: %s <timeline> [<csv>]\n", argv[0]);
+		exit(1);
+	}
+
+	if ((in = fopen(argv[1], "rb")) == NULL) {
+		fprintf(stderr, "Error: cannot open %s\n", argv[1]);
+		exit(1);
+	}
+	if ((argc == 3) && ((out = fopen(argv[2], "w")) == NULL)) {
+		fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+		exit(1);
+	}
+
+	if (!ssd_trace_read_header(in, SSD_POWER_TRACE_MAGIC, sizeof(ssd_power_record))) {
+		fprintf(stderr, "Error: %s is not a power timeline\n", argv[1]);
+		exit(1);
+	}
+
+	while (fread(&rec, sizeof(rec), 1, in) == 1) {
+		switch (rec.type) {
+		case SSD_POWER_REC_HEADER:
+			fprintf(out, "#SSD Power Distribution \n");
+			fprintf(out, "#time(mSec),Current(mA),Power(mW),Cost(mSec),TOTAL_P(mJ),\n");
+		break;
+
+		case SSD_POWER_REC_SECTION:
+			fprintf(out, "%6.4f,%6.4f,%6.4f,%6.4f,%6.4f,\n", rec.time, rec.current, rec.power, rec.cost, rec.energy);
+		break;
+
+		case SSD_POWER_REC_CURRENT:
+			fprintf(out, "%6.4f,%6.4f,\n", rec.time, rec.current);
+		break;
+
+		default:
+			fprintf(stderr, "Error: unknown record type %d in %s\n", rec.type, argv[1]);
+			exit(1);
+		}
+	}
+
+	fclose(in);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
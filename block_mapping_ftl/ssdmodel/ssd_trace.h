@@ -0,0 +1,24 @@
+#ifndef DISKSIM_SSD_TRACE_H
+#define DISKSIM_SSD_TRACE_H
+
+#include <stdio.h>
+
+/*
+ * binary traces of fixed size records. the records are appended to a
+ * ring buffer that a background thread writes out to the file. a
+ * trace file starts with an 8 byte magic and the record size (int).
+ */
+#define SSD_TRACE_MAGIC_LEN		8
+
+typedef struct _ssd_trace ssd_trace;
+
+ssd_trace *ssd_trace_open(FILE *fp, const char *magic, int record_size);
+void ssd_trace_append(ssd_trace *t, const void *rec);
+
+// writes out every open trace, called at the end of the run
+void ssd_trace_flush_all(void);
+
+// used by the converters to check the header of a trace file
+int ssd_trace_read_header(FILE *fp, const char *magic, int record_size);
+
+#endif
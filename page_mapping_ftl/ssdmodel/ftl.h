@@ -35,6 +35,8 @@ void ssd_compute_access_time(ssd_t *s, int elem_num, ssd_req **reqs, int total);
 // for Cleaning
 double ssd_clean_element(ssd_t *s, int elem_num);
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s);
+void ssd_victim_index_init(ssd_element_metadata *metadata, ssd_t *s);
+void ssd_cold_index_init(ssd_element_metadata *metadata, ssd_t *s);
 
 #endif   /* DISKSIM_FTL_H */
 
@@ -8,6 +8,7 @@
 //@20090831-Micky::added
 #include "ssd_power.h"
 //--
+#include "ssd_dftl.h"
 
 /*
  * return true if two blocks belong to the same plane.
@@ -46,6 +47,282 @@ static double ssd_crossover_cost
     }
 }
 
+/*
+ * victim index: every sealed block of a plane is linked on one of the
+ * plane's victim lists according to its num of valid pages. this lets
+ * the greedy cleaner find the least used blocks without scanning the
+ * whole element. the lists are updated whenever a block gets sealed,
+ * loses a valid page or gets erased.
+ */
+static void ssd_victim_index_unlink(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+    plane_metadata *pm = &metadata->plane_meta[bm->plane_num];
+
+    if (bm->victim_prev != -1) {
+        metadata->block_usage[bm->victim_prev].victim_next = bm->victim_next;
+    } else {
+        ASSERT(pm->victim_list[bm->victim_bucket] == blk);
+        pm->victim_list[bm->victim_bucket] = bm->victim_next;
+    }
+
+    if (bm->victim_next != -1) {
+        metadata->block_usage[bm->victim_next].victim_prev = bm->victim_prev;
+    }
+
+    bm->victim_bucket = -1;
+    bm->victim_prev = -1;
+    bm->victim_next = -1;
+}
+
+static void ssd_victim_index_link(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+    plane_metadata *pm = &metadata->plane_meta[bm->plane_num];
+    int bucket = bm->num_valid;
+
+    bm->victim_bucket = bucket;
+    bm->victim_prev = -1;
+    bm->victim_next = pm->victim_list[bucket];
+    if (bm->victim_next != -1) {
+        metadata->block_usage[bm->victim_next].victim_prev = blk;
+    }
+    pm->victim_list[bucket] = blk;
+
+    if (bucket < pm->victim_min) {
+        pm->victim_min = bucket;
+    }
+}
+
+/*
+ * adds a block that just got sealed to the victim index.
+ */
+void ssd_victim_index_insert(int blk, ssd_element_metadata *metadata)
+{
+    ASSERT(metadata->block_usage[blk].victim_bucket == -1);
+    ssd_victim_index_link(blk, metadata);
+}
+
+/*
+ * removes a block from the victim index (when it is erased).
+ */
+void ssd_victim_index_remove(int blk, ssd_element_metadata *metadata)
+{
+    if (metadata->block_usage[blk].victim_bucket != -1) {
+        ssd_victim_index_unlink(blk, metadata);
+    }
+}
+
+/*
+ * moves an indexed block to the list matching its current num of valid pages.
+ */
+void ssd_victim_index_update(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+
+    if ((bm->victim_bucket != -1) && (bm->victim_bucket != bm->num_valid)) {
+        ssd_victim_index_unlink(blk, metadata);
+        ssd_victim_index_link(blk, metadata);
+    }
+}
+
+/*
+ * allocates the victim lists of an element and indexes all the blocks
+ * that are already sealed.
+ */
+void ssd_victim_index_init(ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        if (!(pm->victim_list = (int *)malloc(sizeof(int) * (s->params.pages_per_block + 1)))) {
+            fprintf(stderr, "Error: malloc to victim_list in ssd_victim_index_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(int) * (s->params.pages_per_block + 1));
+            exit(1);
+        }
+
+        for (j = 0; j <= s->params.pages_per_block; j ++) {
+            pm->victim_list[j] = -1;
+        }
+        pm->victim_min = s->params.pages_per_block + 1;
+    }
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        metadata->block_usage[i].victim_bucket = -1;
+        metadata->block_usage[i].victim_prev = -1;
+        metadata->block_usage[i].victim_next = -1;
+
+        if (ssd_can_clean_block(s, metadata, i)) {
+            ssd_victim_index_insert(i, metadata);
+        }
+    }
+}
+
+/*
+ * returns the lowest victim list index that can have blocks in it.
+ */
+static int ssd_victim_index_min(int plane_num, ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+    int min = s->params.pages_per_block + 1;
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        if ((plane_num != -1) && (i != plane_num)) {
+            continue;
+        }
+
+        // skip over the lists that have been emptied since
+        while ((pm->victim_min <= s->params.pages_per_block) && (pm->victim_list[pm->victim_min] == -1)) {
+            pm->victim_min ++;
+        }
+
+        if (pm->victim_min < min) {
+            min = pm->victim_min;
+        }
+    }
+
+    return min;
+}
+
+/*
+ * cold block index: the blocks of a plane that hold valid data are kept
+ * in a binary min-heap ordered by the time of their last erasure, so that
+ * cold data migration finds the coldest block without scanning the plane.
+ * a block enters the heap when its first page gets written after an
+ * erasure and leaves it when its last valid page is invalidated or
+ * migrated away.
+ */
+#define SSD_COLD_KEY(blk, metadata) ((metadata)->block_usage[(blk)].time_of_last_erasure)
+
+static void ssd_cold_index_place(int pos, int blk, ssd_element_metadata *metadata, plane_metadata *pm)
+{
+    pm->cold_heap[pos] = blk;
+    metadata->block_usage[blk].cold_pos = pos;
+}
+
+static void ssd_cold_index_sift_up(int pos, ssd_element_metadata *metadata, plane_metadata *pm)
+{
+    int blk = pm->cold_heap[pos];
+
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (SSD_COLD_KEY(pm->cold_heap[parent], metadata) <= SSD_COLD_KEY(blk, metadata)) {
+            break;
+        }
+        ssd_cold_index_place(pos, pm->cold_heap[parent], metadata, pm);
+        pos = parent;
+    }
+    ssd_cold_index_place(pos, blk, metadata, pm);
+}
+
+static void ssd_cold_index_sift_down(int pos, ssd_element_metadata *metadata, plane_metadata *pm)
+{
+    int blk = pm->cold_heap[pos];
+
+    while (1) {
+        int child = 2 * pos + 1;
+        if (child >= pm->cold_count) {
+            break;
+        }
+        if ((child + 1 < pm->cold_count) &&
+            (SSD_COLD_KEY(pm->cold_heap[child + 1], metadata) < SSD_COLD_KEY(pm->cold_heap[child], metadata))) {
+            child ++;
+        }
+        if (SSD_COLD_KEY(blk, metadata) <= SSD_COLD_KEY(pm->cold_heap[child], metadata)) {
+            break;
+        }
+        ssd_cold_index_place(pos, pm->cold_heap[child], metadata, pm);
+        pos = child;
+    }
+    ssd_cold_index_place(pos, blk, metadata, pm);
+}
+
+/*
+ * adds, removes or repositions a block in the cold block index
+ * according to its current num of valid pages and erasure time.
+ */
+void ssd_cold_index_update(int blk, ssd_element_metadata *metadata)
+{
+    block_metadata *bm = &metadata->block_usage[blk];
+    plane_metadata *pm = &metadata->plane_meta[bm->plane_num];
+    int pos = bm->cold_pos;
+
+    if (bm->num_valid > 0) {
+        if (pos == -1) {
+            pos = pm->cold_count ++;
+            ssd_cold_index_place(pos, blk, metadata, pm);
+        }
+        ssd_cold_index_sift_up(pos, metadata, pm);
+        ssd_cold_index_sift_down(bm->cold_pos, metadata, pm);
+    } else if (pos != -1) {
+        int last = pm->cold_heap[-- pm->cold_count];
+
+        bm->cold_pos = -1;
+        if (last != blk) {
+            ssd_cold_index_place(pos, last, metadata, pm);
+            ssd_cold_index_sift_up(pos, metadata, pm);
+            ssd_cold_index_sift_down(metadata->block_usage[last].cold_pos, metadata, pm);
+        }
+    }
+}
+
+/*
+ * allocates the cold block heaps of an element and indexes all the
+ * blocks that already hold valid data.
+ */
+void ssd_cold_index_init(ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        if (!(pm->cold_heap = (int *)malloc(sizeof(int) * s->params.blocks_per_plane))) {
+            fprintf(stderr, "Error: malloc to cold_heap in ssd_cold_index_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(int) * s->params.blocks_per_plane);
+            exit(1);
+        }
+        pm->cold_count = 0;
+    }
+
+    for (i = 0; i < s->params.blocks_per_element; i ++) {
+        metadata->block_usage[i].cold_pos = -1;
+        ssd_cold_index_update(i, metadata);
+    }
+}
+
+/*
+ * returns the block holding valid data that was erased the longest
+ * time ago, either in the given plane or in the whole element (when
+ * plane_num is -1). returns -1 if there is no such block.
+ */
+static int ssd_cold_index_min(int plane_num, ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+    int from_blk = -1;
+    double oldest_erase_time = simtime;
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        plane_metadata *pm = &metadata->plane_meta[i];
+
+        if (((plane_num != -1) && (i != plane_num)) || (pm->cold_count == 0)) {
+            continue;
+        }
+
+        if (SSD_COLD_KEY(pm->cold_heap[0], metadata) < oldest_erase_time) {
+            oldest_erase_time = SSD_COLD_KEY(pm->cold_heap[0], metadata);
+            from_blk = pm->cold_heap[0];
+        }
+    }
+
+    return from_blk;
+}
+
 /*
  * writes a page to the current active page. if there is no active page,
  * allocate one and then move.
@@ -97,6 +374,11 @@ static double ssd_clean_one_page
 
     cost += ssd_move_page(lp_num, blk, plane_num, elem_num, s);
 
+    // the new location goes to the mapping table
+    if (s->dftl != NULL) {
+        cost += ssd_dftl_relocate(s, elem_num, lp_num, blk);
+    }
+
     // if the write is within the same plane, then the data need
     // not cross the pins. but if not, add the cost of transferring
     // the bytes across the pins
@@ -124,8 +406,17 @@ static double ssd_clean_one_page
  */
 void ssd_update_block_lifetime(double time, int blk, ssd_element_metadata *metadata)
 {
+    long long erasures = SSD_MAX_ERASURES - metadata->block_usage[blk].rem_lifetime;
+
     metadata->block_usage[blk].rem_lifetime --;
     metadata->block_usage[blk].time_of_last_erasure = time;
+    ssd_cold_index_update(blk, metadata);
+
+    // update the running wear statistics. the square of the
+    // block's erasure count grows from e^2 to (e+1)^2.
+    metadata->plane_meta[metadata->block_usage[blk].plane_num].tot_erasures ++;
+    metadata->tot_erasures ++;
+    metadata->tot_erasures_sqr += 2 * erasures + 1;
 
     if (metadata->block_usage[blk].rem_lifetime < 0) {
         fprintf(stderr, "Error: Negative lifetime %d (block is being erased after it's dead)\n",
@@ -148,6 +439,7 @@ void ssd_update_free_block_status(int blk, int plane_num, ssd_element_metadata *
     ssd_clear_bit(metadata->free_blocks, bitpos);
     metadata->block_usage[blk].state = SSD_BLOCK_CLEAN;
     metadata->block_usage[blk].bsn = 0;
+    ssd_victim_index_remove(blk, metadata);
     metadata->tot_free_blocks ++;
     metadata->plane_meta[plane_num].free_blocks ++;
     ssd_assert_free_blocks(s, metadata);
@@ -202,22 +494,14 @@ int ssd_rate_limit(int block_life, double avg_lifetime)
 
 /*
  * computes the average lifetime of all the blocks in a plane.
+ * the average remaining life time is the max num of erasures less
+ * the average num of erasures performed on the blocks so far.
  */
 double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
 {
-    int i;
-    int bitpos;
-    double tot_lifetime = 0;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    bitpos = plane_num * s->params.blocks_per_plane;
-    for (i = bitpos; i < bitpos + (int)s->params.blocks_per_plane; i ++) {
-        int block = ssd_bitpos_to_block(i, s);
-        ASSERT(metadata->block_usage[block].plane_num == plane_num);
-        tot_lifetime += metadata->block_usage[block].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_plane);
+    return (SSD_MAX_ERASURES - ((double)metadata->plane_meta[plane_num].tot_erasures / s->params.blocks_per_plane));
 }
 
 
@@ -226,15 +510,9 @@ double ssd_compute_avg_lifetime_in_plane(int plane_num, int elem_num, ssd_t *s)
  */
 double ssd_compute_avg_lifetime_in_element(int elem_num, ssd_t *s)
 {
-    double tot_lifetime = 0;
-    int i;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        tot_lifetime += metadata->block_usage[i].rem_lifetime;
-    }
-
-    return (tot_lifetime / s->params.blocks_per_element);
+    return (SSD_MAX_ERASURES - ((double)metadata->tot_erasures / s->params.blocks_per_element));
 }
 
 double ssd_compute_avg_lifetime(int plane_num, int elem_num, ssd_t *s)
@@ -344,8 +622,7 @@ static int _ssd_pick_block_to_clean
 int ssd_migrate_cold_data(int to_blk, double *mcost, int plane_num, int elem_num, ssd_t *s)
 {
     int i;
-    int from_blk = -1;
-    double oldest_erase_time = simtime;
+    int from_blk;
     double cost = 0;
     int bitpos;
     ssd_power_element_stat *power_stat = &(s->elements[elem_num].power_stat);
@@ -361,35 +638,14 @@ int ssd_migrate_cold_data(int to_blk, double *mcost, int plane_num, int elem_num
     // first select the coldest of all blocks.
     // one way to select is to find the one that has the oldest
     // erasure time.
-    if (plane_num == -1) {
-        for (i = 0; i < s->params.blocks_per_element; i ++) {
-            if (metadata->block_usage[i].num_valid > 0) {
-                if (metadata->block_usage[i].time_of_last_erasure < oldest_erase_time) {
-                    oldest_erase_time = metadata->block_usage[i].time_of_last_erasure;
-                    from_blk = i;
-                }
-            }
-        }
-    } else {
-
 #if SSD_ASSERT_ALL
+    if (plane_num != -1) {
         f1 = ssd_free_bits(plane_num, elem_num, metadata, s);
         ASSERT(f1 == metadata->plane_meta[metadata->block_usage[to_blk].plane_num].free_blocks);
+    }
 #endif
 
-        bitpos = plane_num * s->params.blocks_per_plane;
-        for (i = bitpos; i < bitpos + (int)s->params.blocks_per_plane; i ++) {
-            int block = ssd_bitpos_to_block(i, s);
-            ASSERT(metadata->block_usage[block].plane_num == plane_num);
-
-            if (metadata->block_usage[block].num_valid > 0) {
-                if (metadata->block_usage[block].time_of_last_erasure < oldest_erase_time) {
-                    oldest_erase_time = metadata->block_usage[block].time_of_last_erasure;
-                    from_blk = block;
-                }
-            }
-        }
-    }
+    from_blk = ssd_cold_index_min(plane_num, metadata, s);
 
     ASSERT(from_blk != -1);
     if (plane_num != -1) {
@@ -433,11 +689,22 @@ int ssd_migrate_cold_data(int to_blk, double *mcost, int plane_num, int elem_num
         if (lpn != -1) {
             ASSERT(metadata->lba_table[lpn] == (from_blk * s->params.pages_per_block + i));
             metadata->lba_table[lpn] = to_blk * s->params.pages_per_block + i;
+            if (s->dftl != NULL) {
+                cost += ssd_dftl_relocate(s, elem_num, lpn, from_blk);
+            }
         }
         metadata->block_usage[to_blk].page[i] = metadata->block_usage[from_blk].page[i];
     }
     metadata->block_usage[to_blk].state = metadata->block_usage[from_blk].state;
 
+    // the cold data now lives in to_blk and from_blk is left with no valid pages
+    if (metadata->block_usage[to_blk].state == SSD_BLOCK_SEALED) {
+        ssd_victim_index_insert(to_blk, metadata);
+    }
+    ssd_victim_index_update(from_blk, metadata);
+    ssd_cold_index_update(to_blk, metadata);
+    ssd_cold_index_update(from_blk, metadata);
+
     bitpos = ssd_block_to_bitpos(s, to_blk);
     ssd_set_bit(metadata->free_blocks, bitpos);
     metadata->tot_free_blocks --;
@@ -497,89 +764,71 @@ int ssd_pick_wear_aware_with_migration
 
 /*
  * a greedy solution, where we find the block in a plane with the least
- * num of valid pages and return it.
+ * num of valid pages and return it. the candidates are taken from the
+ * victim index in the increasing order of their valid pages.
  */
 static int ssd_pick_block_to_clean2(int plane_num, int elem_num, double *mcost, ssd_element_metadata *metadata, ssd_t *s)
 {
     double avg_lifetime = 1;
     int i;
-    int size;
+    int p;
     int block = -1;
-    int min_valid = s->params.pages_per_block - 1; // one page goes for the summary info
-    listnode *greedy_list;
+    int first = -1;
+    int max_valid = s->params.pages_per_block - 1; // one page goes for the summary info
 
     *mcost = 0;
 
     // find the average life time of all the blocks in this element
-    avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
-
-    // we create a list of greedily selected blocks
-    ll_create(&greedy_list);
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-
-            // greedily select the block
-            if (metadata->block_usage[i].num_valid <= min_valid) {
-                ASSERT(i == metadata->block_usage[i].block_num);
-                ll_insert_at_head(greedy_list, (void*)&metadata->block_usage[i]);
-                min_valid = metadata->block_usage[i].num_valid;
-                block = i;
-            }
-        }
+    if (s->params.cleaning_policy != DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
+        avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
     }
 
-    ASSERT(block != -1);
-    block = -1;
+    for (i = ssd_victim_index_min(plane_num, metadata, s); i <= max_valid; i ++) {
+        for (p = 0; p < s->params.planes_per_pkg; p ++) {
+            int blk;
 
-    // from the greedily picked blocks, select one after rate
-    // limiting the overly used blocks
-    size = ll_get_size(greedy_list);
-
-    //printf("plane %d elem %d size %d avg lifetime %f\n",
-    //  plane_num, elem_num, size, avg_lifetime);
+            if ((plane_num != -1) && (p != plane_num)) {
+                continue;
+            }
 
-    for (i = 0; i < size; i ++) {
-        block_metadata *bm;
-        int mig_blk;
+            for (blk = metadata->plane_meta[p].victim_list[i]; blk != -1; blk = metadata->block_usage[blk].victim_next) {
+                block_metadata *bm = &metadata->block_usage[blk];
+                int mig_blk;
 
-        listnode *n = ll_get_nth_node(greedy_list, i);
-        bm = ((block_metadata *)n->data);
+                ASSERT(bm->num_valid == i);
+                if (!_ssd_pick_block_to_clean(blk, plane_num, elem_num, metadata, s)) {
+                    continue;
+                }
 
-        if (i == 0) {
-            ASSERT(min_valid == bm->num_valid);
-        }
+                if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
+                    return blk;
+                }
 
-        // this is the last of the greedily picked blocks.
-        if (i == size -1) {
-            // select it!
-            block = bm->block_num;
-            break;
-        }
+                // remember the least used block in case every
+                // candidate gets rate limited
+                if (first == -1) {
+                    first = blk;
+                }
 
-        if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AGNOSTIC) {
-            block = bm->block_num;
-            break;
-        } else {
 #if MIGRATE
-            // migration
-            mig_blk = ssd_pick_wear_aware_with_migration(bm->block_num, bm->rem_lifetime, avg_lifetime, mcost, bm->plane_num, elem_num, s);
-            if (mig_blk != bm->block_num) {
-                // data has been migrated and we have a new
-                // block to use
-                block = mig_blk;
-                break;
-            }
+                // migration
+                mig_blk = ssd_pick_wear_aware_with_migration(blk, bm->rem_lifetime, avg_lifetime, mcost, bm->plane_num, elem_num, s);
+                if (mig_blk != blk) {
+                    // data has been migrated and we have a new
+                    // block to use
+                    return mig_blk;
+                }
 #endif
 
-            // pick this block giving consideration to its life time
-            if (ssd_pick_wear_aware(bm->block_num, bm->rem_lifetime, avg_lifetime, s)) {
-                block = bm->block_num;
-                break;
+                // pick this block giving consideration to its life time
+                if (ssd_pick_wear_aware(blk, bm->rem_lifetime, avg_lifetime, s)) {
+                    return blk;
+                }
             }
         }
     }
 
-    ll_release(greedy_list);
+    block = first;
 
     ASSERT(block != -1);
     return block;
@@ -588,25 +837,28 @@ static int ssd_pick_block_to_clean2(int plane_num, int elem_num, double *mcost,
 static int ssd_pick_block_to_clean1(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
     int i;
-    int block = -1;
-    int min_valid = s->params.pages_per_block - 1; // one page goes for the summary info
+    int p;
+    int max_valid = s->params.pages_per_block - 1; // one page goes for the summary info
 
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        if (_ssd_pick_block_to_clean(i, plane_num, elem_num, metadata, s)) {
-            if (metadata->block_usage[i].num_valid < min_valid) {
-                min_valid = metadata->block_usage[i].num_valid;
-                block = i;
+    for (i = ssd_victim_index_min(plane_num, metadata, s); i < max_valid; i ++) {
+        for (p = 0; p < s->params.planes_per_pkg; p ++) {
+            int blk;
+
+            if ((plane_num != -1) && (p != plane_num)) {
+                continue;
+            }
+
+            for (blk = metadata->plane_meta[p].victim_list[i]; blk != -1; blk = metadata->block_usage[blk].victim_next) {
+                if (_ssd_pick_block_to_clean(blk, plane_num, elem_num, metadata, s)) {
+                    return blk;
+                }
             }
         }
     }
 
-    if (block != -1) {
-        return block;
-    } else {
-        fprintf(stderr, "Error: we cannot find a block to clean in plane %d\n", plane_num);
-        ASSERT(0);
-        exit(1);
-    }
+    fprintf(stderr, "Error: we cannot find a block to clean in plane %d\n", plane_num);
+    ASSERT(0);
+    exit(1);
 }
 
 static int ssd_pick_block_to_clean(int plane_num, int elem_num, double *mcost, ssd_element_metadata *metadata, ssd_t *s)
@@ -725,54 +977,6 @@ static double ssd_clean_block_fully(int plane_num, int elem_num, ssd_t *s)
 }
 
 
-static usage_table *ssd_build_usage_table(int elem_num, ssd_t *s)
-{
-    int i;
-    usage_table *table;
-    ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-
-    //////////////////////////////////////////////////////////////////////////////
-    // allocate the hash table. it has (pages_per_block + 1) entries,
-    // one entry for values from 0 to pages_per_block.
-    table = (usage_table *) malloc(sizeof(usage_table) * (s->params.pages_per_block + 1));
-    memset(table, 0, sizeof(usage_table) * (s->params.pages_per_block + 1));
-
-    // find out how many blocks have a particular no of valid pages
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        int usage = metadata->block_usage[i].num_valid;
-        table[usage].len ++;
-    }
-
-    // allocate space to store the block numbers
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        table[i].block = (int*)malloc(sizeof(int)*table[i].len);
-    }
-
-    /////////////////////////////////////////////////////////////////////////////
-    // fill in the block numbers in their appropriate 'usage' buckets
-    for (i = 0; i < s->params.blocks_per_element; i ++) {
-        usage_table *entry;
-        int usage = metadata->block_usage[i].num_valid;
-
-        entry = &(table[usage]);
-        entry->block[entry->temp ++] = i;
-    }
-
-    return table;
-}
-
-static void ssd_release_usage_table(usage_table *table, ssd_t *s)
-{
-    int i;
-
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        free(table[i].block);
-    }
-
-    // release the table
-    free(table);
-}
-
 /*
  * pick a random block with at least 1 empty page slot and clean it
  */
@@ -826,8 +1030,8 @@ static double ssd_clean_blocks_random(int plane_num, int elem_num, ssd_t *s)
 #define GREEDY_IN_COPYBACK 0
 
 /*
- * first we create a hash table of blocks according to their
- * usage. then we select blocks with the least usage and clean
+ * the victim index already keeps the sealed blocks bucketed by their
+ * usage. we walk the buckets from the least used blocks and clean
  * them.
  */
 static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
@@ -835,75 +1039,77 @@ static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
     double cost = 0;
     double avg_lifetime;
     int i;
-    usage_table *table;
+    int p;
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
 
-    /////////////////////////////////////////////////////////////////////////////
-    // build the histogram
-    table = ssd_build_usage_table(elem_num, s);
-
     //////////////////////////////////////////////////////////////////////////////
     // find the average life time of all the blocks in this element
     avg_lifetime = ssd_compute_avg_lifetime(plane_num, elem_num, s);
 
     /////////////////////////////////////////////////////////////////////////////
-    // we now have a hash table of blocks, where the key of each
-    // bucket is the usage count and each bucket has all the blocks with
-    // the same usage count (i.e., the same num of valid pages).
-    for (i = 0; i <= s->params.pages_per_block; i ++) {
-        int j;
-        usage_table *entry;
-
-        // get the bucket of blocks with 'i' valid pages
-        entry = &(table[i]);
-
-        // free all the blocks with 'i' valid pages
-        for (j = 0; j < entry->len; j ++) {
-            int blk = entry->block[j];
-            int block_life = metadata->block_usage[blk].rem_lifetime;
+    // the key of each victim list is the usage count and each list has
+    // all the sealed blocks with the same usage count (i.e., the same num
+    // of valid pages).
+    for (i = ssd_victim_index_min(plane_num, metadata, s); i <= s->params.pages_per_block; i ++) {
+        for (p = 0; p < s->params.planes_per_pkg; p ++) {
+            int blk;
+            int next;
 
             // if this is plane specific cleaning, then skip all the
             // blocks that don't belong to this plane.
-            if ((plane_num != -1) && (metadata->block_usage[blk].plane_num != plane_num)) {
+            if ((plane_num != -1) && (p != plane_num)) {
                 continue;
             }
 
-            // if the block is already dead, skip it
-            if (block_life == 0) {
-                continue;
-            }
+            // free all the blocks with 'i' valid pages. cleaning a block
+            // unlinks only that block (and may link a newly sealed block at
+            // the head of a list), so we remember the next one beforehand.
+            for (blk = metadata->plane_meta[p].victim_list[i]; blk != -1; blk = next) {
+                int block_life = metadata->block_usage[blk].rem_lifetime;
 
-            // clean only those blocks that are sealed.
-            if (ssd_can_clean_block(s, metadata, blk)) {
+                next = metadata->block_usage[blk].victim_next;
 
-                // if we care about wear-leveling, then we must rate limit overly cleaned blocks
-                if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
-
-                    // see if this block's remaining lifetime is within
-                    // a certain threshold of the average remaining lifetime
-                    // of all blocks in this element
-                    if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
-                        // we have to rate limit this block as it has exceeded
-                        // its cleaning limits
-                        printf("Rate limiting block %d (block life %d avg life %f\n",
-                            blk, block_life, avg_lifetime);
+                // if the block is already dead, skip it
+                if (block_life == 0) {
+                    continue;
+                }
 
-                        if (ssd_rate_limit(block_life, avg_lifetime)) {
-                            // skip this block and go to the next one
-                            continue;
+                // clean only those blocks that are sealed.
+                if (ssd_can_clean_block(s, metadata, blk)) {
+
+                    // if we care about wear-leveling, then we must rate limit overly cleaned blocks
+                    if (s->params.cleaning_policy == DISKSIM_SSD_CLEANING_POLICY_GREEDY_WEAR_AWARE) {
+
+                        // see if this block's remaining lifetime is within
+                        // a certain threshold of the average remaining lifetime
+                        // of all blocks in this element
+                        if (block_life < (SSD_LIFETIME_THRESHOLD_X * avg_lifetime)) {
+                            // we have to rate limit this block as it has exceeded
+                            // its cleaning limits
+                            printf("Rate limiting block %d (block life %d avg life %f\n",
+                                blk, block_life, avg_lifetime);
+
+                            if (ssd_rate_limit(block_life, avg_lifetime)) {
+                                // skip this block and go to the next one
+                                continue;
+                            }
                         }
                     }
-                }
 
-                // okies, finally here we're with the block to be cleaned.
-                // invoke cleaning until we reach the high watermark.
-                cost += _ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
+                    // okies, finally here we're with the block to be cleaned.
+                    // invoke cleaning until we reach the high watermark.
+                    cost += _ssd_clean_block_fully(blk, metadata->block_usage[blk].plane_num, elem_num, metadata, s);
 
-                if (ssd_stop_cleaning(plane_num, elem_num, s)) {
-                    // no more cleaning is required -- so quit.
-                    break;
+                    if (ssd_stop_cleaning(plane_num, elem_num, s)) {
+                        // no more cleaning is required -- so quit.
+                        break;
+                    }
                 }
             }
+
+            if (ssd_stop_cleaning(plane_num, elem_num, s)) {
+                break;
+            }
         }
 
         if (ssd_stop_cleaning(plane_num, elem_num, s)) {
@@ -912,9 +1118,6 @@ static double ssd_clean_blocks_greedy(int plane_num, int elem_num, ssd_t *s)
         }
     }
 
-    // release the table
-    ssd_release_usage_table(table, s);
-
     // see if we were able to generate enough free blocks
     if (!ssd_stop_cleaning(plane_num, elem_num, s)) {
         printf("Yuck! we couldn't generate enough free pages in plane %d elem %d ssd %d\n",
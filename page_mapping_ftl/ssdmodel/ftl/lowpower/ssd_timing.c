@@ -10,6 +10,7 @@
 //@20090831-Micky::added
 #include "ssd_power.h"
 //--
+#include "ssd_dftl.h"
 
 struct my_timing_t {
     ssd_timing_params    *params;
@@ -53,16 +54,9 @@ double ssd_read_policy_simple(int count, ssd_t *s, ssd_power_element_stat *power
  */
 int ssd_free_bits(int plane_num, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
-    int i;
-    int freecount = 0;
     int start = plane_num * s->params.blocks_per_plane;
-    for (i = start; i < start + (int)s->params.blocks_per_plane; i ++) {
-        if (!ssd_bit_on(metadata->free_blocks, i)) {
-            freecount ++;
-        }
-    }
 
-    return freecount;
+    return ssd_count_zero_bits(metadata->free_blocks, start, start + s->params.blocks_per_plane);
 }
 
 /*
@@ -283,6 +277,8 @@ double _ssd_write_page_osr(ssd_t *s, ssd_element_metadata *metadata, int lpn, ss
             metadata->block_usage[prev_block].page[pagepos_in_prev_block] = -1;
             metadata->block_usage[prev_block].num_valid --;
             metadata->plane_meta[prev_plane].valid_pages --;
+            ssd_victim_index_update(prev_block, metadata);
+            ssd_cold_index_update(prev_block, metadata);
             ssd_assert_valid_pages(prev_plane, metadata, s);
         }
     } else {
@@ -296,6 +292,7 @@ double _ssd_write_page_osr(ssd_t *s, ssd_element_metadata *metadata, int lpn, ss
     metadata->block_usage[active_block].page[pagepos_in_block] = lpn;
     metadata->block_usage[active_block].num_valid ++;
     metadata->plane_meta[active_plane].valid_pages ++;
+    ssd_cold_index_update(active_block, metadata);
     ssd_assert_valid_pages(active_plane, metadata, s);
 
     // some sanity checking
@@ -346,6 +343,7 @@ double _ssd_write_page_osr(ssd_t *s, ssd_element_metadata *metadata, int lpn, ss
         // as a metadata, we don't count it as a valid data page.
         metadata->block_usage[active_block].page[s->params.pages_per_block - 1] = -1;
         metadata->block_usage[active_block].state = SSD_BLOCK_SEALED;
+        ssd_victim_index_insert(active_block, metadata);
         //printf("SUMMARY: lpn %d active pg %d\n", lpn, active_page);
     }
 
@@ -363,7 +361,7 @@ double _ssd_write_page_osr(ssd_t *s, ssd_element_metadata *metadata, int lpn, ss
 void _ssd_alloc_active_block(int plane_num, int elem_num, ssd_t *s)
 {
     ssd_element_metadata *metadata = &(s->elements[elem_num].metadata);
-    unsigned char *free_blocks = metadata->free_blocks;
+    ssd_bitmap *free_blocks = metadata->free_blocks;
     int active_block = -1;
     int prev_pos;
     int bitpos;
@@ -374,34 +372,25 @@ void _ssd_alloc_active_block(int plane_num, int elem_num, ssd_t *s)
         prev_pos = metadata->block_alloc_pos;
     }
 
-    // find a free bit
-    bitpos = ssd_find_zero_bit(free_blocks, s->params.blocks_per_element, prev_pos);
-    ASSERT((bitpos >= 0) && (bitpos < s->params.blocks_per_element));
-
-    // check if we found the free bit in the plane we wanted to
     if (plane_num != -1) {
-        if (ssd_bitpos_to_plane(bitpos, s) != plane_num) {
-
-            //printf("Error: We wanted a free block in plane %d but found another in %d\n",
-            //  plane_num, ssd_bitpos_to_plane(bitpos, s));
-            //printf("So, starting the search again for plane %d\n", plane_num);
-
-            // start from the beginning
-            metadata->plane_meta[plane_num].block_alloc_pos = plane_num * s->params.blocks_per_plane;
-            prev_pos = metadata->plane_meta[plane_num].block_alloc_pos;
-            bitpos = ssd_find_zero_bit(free_blocks, s->params.blocks_per_element, prev_pos);
-            ASSERT((bitpos >= 0) && (bitpos < s->params.blocks_per_element));
-
-            if (ssd_bitpos_to_plane(bitpos, s) != plane_num) {
-                printf("Error: this plane %d is full\n", plane_num);
-                printf("this case is not yet handled\n");
-                exit(1);
-            }
+        int first = plane_num * s->params.blocks_per_plane;
+
+        // find a free bit in the plane we want to, starting from the
+        // last allocation position and wrapping around to the beginning
+        bitpos = ssd_find_zero_bit_in_range(free_blocks, first, first + s->params.blocks_per_plane, prev_pos);
+        if (bitpos == -1) {
+            printf("Error: this plane %d is full\n", plane_num);
+            printf("this case is not yet handled\n");
+            exit(1);
         }
 
         metadata->plane_meta[plane_num].block_alloc_pos = \
             (plane_num * s->params.blocks_per_plane) + ((bitpos+1) % s->params.blocks_per_plane);
     } else {
+        // find a free bit
+        bitpos = ssd_find_zero_bit(free_blocks, s->params.blocks_per_element, prev_pos);
+        ASSERT((bitpos >= 0) && (bitpos < s->params.blocks_per_element));
+
         metadata->block_alloc_pos = (bitpos+1) % s->params.blocks_per_element;
     }
 
@@ -448,7 +437,56 @@ void _ssd_alloc_active_block(int plane_num, int elem_num, ssd_t *s)
     }
 }
 
-listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
+/*
+ * the per parallel unit request queues used while issuing a batch of
+ * requests. they are fixed size rings preallocated along with the element
+ * metadata, so that dispatching a batch does not touch the heap.
+ */
+static void ssd_parunit_reset(ssd_element_metadata *metadata, ssd_t *s)
+{
+    int i;
+
+    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
+        metadata->parunits[i].ring_head = 0;
+        metadata->parunits[i].ring_count = 0;
+    }
+
+    for (i = 0; i < s->params.planes_per_pkg; i ++) {
+        metadata->plane_meta[i].queued_writes = 0;
+    }
+}
+
+static void ssd_parunit_enqueue(int parunit_num, ssd_req *r, ssd_element_metadata *metadata)
+{
+    parunit *pu = &metadata->parunits[parunit_num];
+
+    if (pu->ring_count >= MAX_REQS_ELEM_QUEUE) {
+        fprintf(stderr, "Error: request queue of parallel unit %d is full\n", parunit_num);
+        exit(1);
+    }
+
+    pu->ring[(pu->ring_head + pu->ring_count) % MAX_REQS_ELEM_QUEUE] = r;
+    pu->ring_count ++;
+
+    // remember how many writes are already headed to this plane
+    if (!r->is_read) {
+        metadata->plane_meta[r->plane_num].queued_writes ++;
+    }
+}
+
+static ssd_req *ssd_parunit_dequeue(parunit *pu)
+{
+    ssd_req *r;
+
+    ASSERT(pu->ring_count > 0);
+    r = pu->ring[pu->ring_head];
+    pu->ring_head = (pu->ring_head + 1) % MAX_REQS_ELEM_QUEUE;
+    pu->ring_count --;
+
+    return r;
+}
+
+void ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_element_metadata *metadata, ssd_t *s)
 {
     int i;
     int lpn;
@@ -456,15 +494,11 @@ listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_elemen
     int prev_block;
     int plane_num;
     int parunit_num;
-    listnode **parunits;
     int filled = 0;
 
-    // parunits is an array of linked list structures, where
-    // each entry in the array corresponds to one parallel unit
-    parunits = (listnode **)malloc(SSD_PARUNITS_PER_ELEM(s) * sizeof(listnode *));
-    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
-        ll_create(&parunits[i]);
-    }
+    // each parallel unit gets a queue of the requests to be
+    // issued on it
+    ssd_parunit_reset(metadata, s);
 
     // first, fill in the reads
     for (i = 0; i < total; i ++) {
@@ -477,14 +511,14 @@ listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_elemen
             plane_num = metadata->block_usage[prev_block].plane_num;
             parunit_num = metadata->plane_meta[plane_num].parunit_num;
             reqs[i]->plane_num = plane_num;
-            ll_insert_at_tail(parunits[parunit_num], (void*)reqs[i]);
+            ssd_parunit_enqueue(parunit_num, reqs[i], metadata);
             filled ++;
         }
     }
 
     // if all the reqs are reads, return
     if (filled == total) {
-        return parunits;
+        return;
     }
 
     for (i = 0; i < total; i ++) {
@@ -519,30 +553,11 @@ listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_elemen
                     if ((active_bsn > prev_bsn) ||
                         ((active_bsn == prev_bsn) && (pm->active_page > (unsigned int)prev_page))) {
                         int free_pages_in_act_blk;
-                        int k;
-                        int p;
                         int tmp;
-                        int size;
-                        int additive = 0;
-
-                        p = metadata->plane_meta[j].parunit_num;
-                        size = ll_get_size(parunits[p]);
-
-                        // check if this plane has been already selected for writing
-                        // in this parallel unit
-                        for (k = 0; k < size; k ++) {
-                            ssd_req *r;
-                            listnode *n = ll_get_nth_node(parunits[p], k);
-                            ASSERT(n != NULL);
+                        int additive;
 
-                            r = ((ssd_req *)n->data);
-
-                            // is this plane has been already selected for writing?
-                            if ((r->plane_num == j) &&
-                                (!r->is_read)) {
-                                additive ++;
-                            }
-                        }
+                        // count the writes that have been already queued on this plane
+                        additive = metadata->plane_meta[j].queued_writes;
 
                         // select a plane with the most no of free pages
                         free_pages_in_act_blk = s->params.pages_per_block - ((pm->active_page%s->params.pages_per_block) + additive);
@@ -571,7 +586,7 @@ listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_elemen
 
                 reqs[i]->plane_num = plane_num;
                 parunit_num = metadata->plane_meta[plane_num].parunit_num;
-                ll_insert_at_tail(parunits[parunit_num], (void *)reqs[i]);
+                ssd_parunit_enqueue(parunit_num, reqs[i], metadata);
                 filled ++;
             } else {
                 fprintf(stderr, "Error: cannot find a plane to write\n");
@@ -581,8 +596,6 @@ listnode **ssd_pick_parunits(ssd_req **reqs, int total, int elem_num, ssd_elemen
     }
 
     ASSERT(filled == total);
-
-    return parunits;
 }
 
 static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num, ssd_t *s)
@@ -596,7 +609,6 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
     int lpn;
     int i;
     int read_cycle = 0;
-    listnode **parunits;
 
     // all the requests must be of the same type
     for (i = 1; i < total; i ++) {
@@ -613,7 +625,7 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
     // find the planes to which the reqs are to be issued
     metadata = &(s->elements[elem_num].metadata);
     power_stat = &(s->elements[elem_num].power_stat);
-    parunits = ssd_pick_parunits(reqs, total, elem_num, metadata, s);
+    ssd_pick_parunits(reqs, total, elem_num, metadata, s);
 
     // repeat until we've served all the requests
     while (1) {
@@ -625,7 +637,7 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
 
         // do we still have any request to service?
         for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
-            if (ll_get_size(parunits[i]) > 0) {
+            if (metadata->parunits[i].ring_count > 0) {
                 active_parunits ++;
             }
         }
@@ -643,21 +655,27 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
         // in the list, they have to be serialized.
         max_cost = 0;
         for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
-            int size;
-
-            size = ll_get_size(parunits[i]);
-            if (size > 0) {
+            if (metadata->parunits[i].ring_count > 0) {
                 // this parallel unit has a request to serve
                 ssd_req *r;
-                listnode *n = ll_get_nth_node(parunits[i], 0);
+                double xfer_cost;
+                double trans_cost;
 
                 op_count ++;
                 ASSERT(op_count <= active_parunits);
 
                 // get the request
-                r = (ssd_req *)n->data;
+                r = ssd_parunit_dequeue(&metadata->parunits[i]);
                 lpn = ssd_logical_pageno(r->blk, s);
 
+                // with a demand-paged mapping table, the translation pages
+                // are read and written before the operation on this unit
+                trans_cost = 0;
+                if (s->dftl != NULL) {
+                    trans_cost = ssd_dftl_translate(s, elem_num, lpn, !r->is_read, parunit_tot_cost[i]);
+                    parunit_tot_cost[i] += trans_cost;
+                }
+
                 if (r->is_read) {
                     parunit_op_cost[i] = s->params.page_read_latency;
                     //Micky
@@ -699,15 +717,25 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
                     r->acctime = parunit_op_cost[i] + ssd_data_transfer_cost(s,r->count);
 					r->schtime = parunit_tot_cost[i] + write_xfer_cost + parunit_op_cost[i];
                 }
+                r->acctime += trans_cost;
+
+                // place the operation and its transfer on the power profile.
+                // a read transfers its data after the page is read, while a
+                // write transfers it before the page is programmed.
+                xfer_cost = ssd_data_transfer_cost(s,r->count);
+                if (read_cycle) {
+                    ssd_power_profile_op(s, elem_num, SSD_POWER_FLASH_READ, parunit_tot_cost[i], parunit_op_cost[i]);
+                    ssd_power_profile_op(s, elem_num, SSD_POWER_FLASH_BUS_DATA_TRANSFER, r->schtime - xfer_cost, xfer_cost);
+                } else {
+                    ssd_power_profile_op(s, elem_num, SSD_POWER_FLASH_BUS_DATA_TRANSFER, r->schtime - parunit_op_cost[i] - xfer_cost, xfer_cost);
+                    ssd_power_profile_op(s, elem_num, SSD_POWER_FLASH_WRITE, r->schtime - parunit_op_cost[i], parunit_op_cost[i]);
+                }
 
 
                 // find the maximum cost for this round of operations
                 if (max_cost < r->schtime) {
                     max_cost = r->schtime;
                 }
-
-                // release the node from the linked list
-                ll_release_node(parunits[i], n);
             }
 		}
 		ssd_power_flash_calculate(SSD_POWER_FLASH_BUS_DATA_TRANSFER, read_xfer_cost, power_stat, s);
@@ -721,12 +749,7 @@ static double ssd_issue_overlapped_ios(ssd_req **reqs, int total, int elem_num,
         }
     }
 
-    for (i = 0; i < SSD_PARUNITS_PER_ELEM(s); i ++) {
-        ll_release(parunits[i]);
-    }
-    free(parunits);
-
-	power_stat->acc_time += max_cost;
+	ssd_power_add_acc_time(max_cost, power_stat, s);
 
     return max_cost;
 }
@@ -808,11 +831,16 @@ static void ssd_compute_access_time_one_active_page
     count = reqs[0]->count;
     is_read = reqs[0]->is_read;
 
+    cost = 0;
+    if (s->dftl != NULL) {
+        cost = ssd_dftl_translate(s, elem_num, ssd_logical_pageno(blkno, s), !is_read, 0);
+    }
+
     if (is_read) {
-        cost = ssd_read_policy_simple(count, s, power_stat);
+        cost += ssd_read_policy_simple(count, s, power_stat);
         
     } else {
-        cost = ssd_write_one_active_page(blkno, count, elem_num, s);
+        cost += ssd_write_one_active_page(blkno, count, elem_num, s);
     }
 
     reqs[0]->acctime = cost;
@@ -846,15 +874,19 @@ static void ssd_compute_access_time_one_active_page
  */
 void ssd_compute_access_time(ssd_t *s, int elem_num, ssd_req **reqs, int total)
 {
+    double prof;
+
     if (total == 0) {
         return;
     }
 
+    prof = ssd_prof_begin(s);
     if (s->params.copy_back == SSD_COPY_BACK_DISABLE) {
         ssd_compute_access_time_one_active_page(reqs, total, elem_num, s);
     } else {
         ssd_issue_overlapped_ios(reqs, total, elem_num, s);
     }
+    ssd_prof_end(s, SSD_PROF_ACCESS_TIME, prof);
 }
 
 void * ssd_new_timing_t(ssd_timing_params *params)
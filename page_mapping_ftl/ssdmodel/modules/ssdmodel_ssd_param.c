@@ -561,6 +561,160 @@ if (! ((d >= 0.0))) { // foo
 
 }
 
+static int SSDMODEL_SSD_POWER_SAMPLE_PERIOD_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_POWER_SAMPLE_PERIOD_loader(struct ssd * result, double d) { 
+if (! ((d >= 0.0))) { // foo 
+ } 
+ result->params.power_sample_period = d;
+
+}
+
+static int SSDMODEL_SSD_POWER_PROFILE_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_POWER_PROFILE_loader(struct ssd * result, int i) { 
+if (! (((i >= 0) && (i <= 2)))) { // foo 
+ } 
+ result->params.power_profile = i;
+
+}
+
+static int SSDMODEL_SSD_POWER_BUDGET_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_POWER_BUDGET_loader(struct ssd * result, double d) { 
+if (! ((d >= 0.0))) { // foo 
+ } 
+ result->params.power_budget = d;
+
+}
+
+static int SSDMODEL_SSD_PAGE_TRACE_SAMPLING_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_PAGE_TRACE_SAMPLING_loader(struct ssd * result, int i) { 
+if (! ((i >= 0))) { // foo 
+ } 
+ result->params.page_trace_sampling = i;
+
+}
+
+static int SSDMODEL_SSD_LATENCY_BREAKDOWN_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_LATENCY_BREAKDOWN_loader(struct ssd * result, int i) { 
+if (! (((i >= 0) && (i <= 1)))) { // foo 
+ } 
+ result->params.latency_breakdown = i;
+
+}
+
+static int SSDMODEL_SSD_CHROME_TRACE_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_CHROME_TRACE_loader(struct ssd * result, int i) { 
+if (! ((i >= 0) && (i <= 1))) { // foo 
+ } 
+ result->params.chrome_trace = i;
+
+}
+
+static int SSDMODEL_SSD_CHROME_TRACE_START_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_CHROME_TRACE_START_loader(struct ssd * result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ result->params.chrome_trace_start = d;
+
+}
+
+static int SSDMODEL_SSD_CHROME_TRACE_END_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_CHROME_TRACE_END_loader(struct ssd * result, double d) { 
+if (! (d >= 0.0)) { // foo 
+ } 
+ result->params.chrome_trace_end = d;
+
+}
+
+static int SSDMODEL_SSD_SELF_PROFILING_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_SELF_PROFILING_loader(struct ssd * result, int i) { 
+if (! (((i >= 0) && (i <= 1)))) { // foo 
+ } 
+ result->params.self_profiling = i;
+
+}
+
+static int SSDMODEL_SSD_BUFFER_CACHE_WINDOW_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_BUFFER_CACHE_WINDOW_loader(struct ssd * result, double d) { 
+if (! (((d >= 0.0) && (d <= 1.0)))) { // foo 
+ } 
+ result->params.dram_cache_window = d;
+
+}
+
+static int SSDMODEL_SSD_BUFFER_CACHE_DESTAGE_BATCH_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_BUFFER_CACHE_DESTAGE_BATCH_loader(struct ssd * result, int i) { 
+if (! ((i >= 0))) { // foo 
+ } 
+ result->params.dram_destage_batch = i;
+
+}
+
+static int SSDMODEL_SSD_READ_CACHE_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_READ_CACHE_loader(struct ssd * result, int i) { 
+if (! (((i >= 0) && (i <= 1)))) { // foo 
+ } 
+ result->params.read_cache = i;
+
+}
+
+static int SSDMODEL_SSD_READ_AHEAD_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_READ_AHEAD_loader(struct ssd * result, int i) { 
+if (! ((i >= 0))) { // foo 
+ } 
+ result->params.read_ahead = i;
+
+}
+
+static int SSDMODEL_SSD_MAPPING_CACHE_SIZE_depend(char *bv) {
+return -1;
+}
+
+static void SSDMODEL_SSD_MAPPING_CACHE_SIZE_loader(struct ssd * result, int i) { 
+if (! ((i >= 0))) { // foo 
+ } 
+ result->params.mapping_cache_size = i;
+
+}
+
 void * SSDMODEL_SSD_loaders[] = {
 (void *)SSDMODEL_SSD_SCHEDULER_loader,
 (void *)SSDMODEL_SSD_MAX_QUEUE_LENGTH_loader,
@@ -612,7 +766,21 @@ void * SSDMODEL_SSD_loaders[] = {
 (void *)SSDMODEL_SSD_DRAM_INPUT_VOLTAGE_loader,
 (void *)SSDMODEL_SSD_DRAM_ACTIVE_LATENCY_loader,
 (void *)SSDMODEL_SSD_BUFFER_CACHE_SIZE_loader,
-(void *)SSDMODEL_SSD_LEAKAGE_POWER_loader
+(void *)SSDMODEL_SSD_LEAKAGE_POWER_loader,
+(void *)SSDMODEL_SSD_POWER_SAMPLE_PERIOD_loader,
+(void *)SSDMODEL_SSD_POWER_PROFILE_loader,
+(void *)SSDMODEL_SSD_POWER_BUDGET_loader,
+(void *)SSDMODEL_SSD_PAGE_TRACE_SAMPLING_loader,
+(void *)SSDMODEL_SSD_LATENCY_BREAKDOWN_loader,
+(void *)SSDMODEL_SSD_CHROME_TRACE_loader,
+(void *)SSDMODEL_SSD_CHROME_TRACE_START_loader,
+(void *)SSDMODEL_SSD_CHROME_TRACE_END_loader,
+(void *)SSDMODEL_SSD_SELF_PROFILING_loader,
+(void *)SSDMODEL_SSD_BUFFER_CACHE_WINDOW_loader,
+(void *)SSDMODEL_SSD_BUFFER_CACHE_DESTAGE_BATCH_loader,
+(void *)SSDMODEL_SSD_READ_CACHE_loader,
+(void *)SSDMODEL_SSD_READ_AHEAD_loader,
+(void *)SSDMODEL_SSD_MAPPING_CACHE_SIZE_loader
 };
 
 lp_paramdep_t SSDMODEL_SSD_deps[] = {
@@ -666,6 +834,20 @@ SSDMODEL_SSD_DRAM_IDLE_CURRENT_depend,
 SSDMODEL_SSD_DRAM_INPUT_VOLTAGE_depend,
 SSDMODEL_SSD_DRAM_ACTIVE_LATENCY_depend,
 SSDMODEL_SSD_BUFFER_CACHE_SIZE_depend,
-SSDMODEL_SSD_LEAKAGE_POWER_depend
+SSDMODEL_SSD_LEAKAGE_POWER_depend,
+SSDMODEL_SSD_POWER_SAMPLE_PERIOD_depend,
+SSDMODEL_SSD_POWER_PROFILE_depend,
+SSDMODEL_SSD_POWER_BUDGET_depend,
+SSDMODEL_SSD_PAGE_TRACE_SAMPLING_depend,
+SSDMODEL_SSD_LATENCY_BREAKDOWN_depend,
+SSDMODEL_SSD_CHROME_TRACE_depend,
+SSDMODEL_SSD_CHROME_TRACE_START_depend,
+SSDMODEL_SSD_CHROME_TRACE_END_depend,
+SSDMODEL_SSD_SELF_PROFILING_depend,
+SSDMODEL_SSD_BUFFER_CACHE_WINDOW_depend,
+SSDMODEL_SSD_BUFFER_CACHE_DESTAGE_BATCH_depend,
+SSDMODEL_SSD_READ_CACHE_depend,
+SSDMODEL_SSD_READ_AHEAD_depend,
+SSDMODEL_SSD_MAPPING_CACHE_SIZE_depend
 };
 
@@ -62,10 +62,24 @@ typedef enum {
    SSDMODEL_SSD_DRAM_INPUT_VOLTAGE,
    SSDMODEL_SSD_DRAM_ACTIVE_LATENCY,
    SSDMODEL_SSD_BUFFER_CACHE_SIZE,
-   SSDMODEL_SSD_LEAKAGE_POWER
+   SSDMODEL_SSD_LEAKAGE_POWER,
+   SSDMODEL_SSD_POWER_SAMPLE_PERIOD,
+   SSDMODEL_SSD_POWER_PROFILE,
+   SSDMODEL_SSD_POWER_BUDGET,
+   SSDMODEL_SSD_PAGE_TRACE_SAMPLING,
+   SSDMODEL_SSD_LATENCY_BREAKDOWN,
+   SSDMODEL_SSD_CHROME_TRACE,
+   SSDMODEL_SSD_CHROME_TRACE_START,
+   SSDMODEL_SSD_CHROME_TRACE_END,
+   SSDMODEL_SSD_SELF_PROFILING,
+   SSDMODEL_SSD_BUFFER_CACHE_WINDOW,
+   SSDMODEL_SSD_BUFFER_CACHE_DESTAGE_BATCH,
+   SSDMODEL_SSD_READ_CACHE,
+   SSDMODEL_SSD_READ_AHEAD,
+   SSDMODEL_SSD_MAPPING_CACHE_SIZE
 } ssdmodel_ssd_param_t;
 
-#define SSDMODEL_SSD_MAX_PARAM		SSDMODEL_SSD_LEAKAGE_POWER
+#define SSDMODEL_SSD_MAX_PARAM		SSDMODEL_SSD_MAPPING_CACHE_SIZE
 extern void * SSDMODEL_SSD_loaders[];
 extern lp_paramdep_t SSDMODEL_SSD_deps[];
 
@@ -122,9 +136,23 @@ static struct lp_varspec ssdmodel_ssd_params [] = {
    {"DRAM active latency", D, 1 },
    {"Buffer cache size", I, 1 },
    {"LEAKAGE power", D, 1 },
+   {"Power sample period", D, 0 },
+   {"Power profile", I, 0 },
+   {"Power budget", D, 0 },
+   {"Page trace sampling", I, 0 },
+   {"Latency breakdown", I, 0 },
+   {"Chrome trace", I, 0 },
+   {"Chrome trace start", D, 0 },
+   {"Chrome trace end", D, 0 },
+   {"Self profiling", I, 0 },
+   {"Buffer cache window", D, 0 },
+   {"Buffer cache destage batch", I, 0 },
+   {"Read cache", I, 0 },
+   {"Read ahead", I, 0 },
+   {"Mapping cache size", I, 0 },
    {0,0,0}
 };
-#define SSDMODEL_SSD_MAX 51
+#define SSDMODEL_SSD_MAX 65
 static struct lp_mod ssdmodel_ssd_mod = { "ssdmodel_ssd", ssdmodel_ssd_params, SSDMODEL_SSD_MAX, (lp_modloader_t)ssdmodel_ssd_loadparams,  0, 0, SSDMODEL_SSD_loaders, SSDMODEL_SSD_deps };
 
 
@@ -4,6 +4,9 @@
 #include "ssd.h"
 #include "ftl.h"
 #include "ssd_gang.h"
+#include "ssd_page_trace.h"
+#include "ssd_chrome_trace.h"
+#include "ssd_cache.h"
 #include "modules/ssdmodel_ssd_param.h"
 
 #include "disksim_stat.h"
@@ -85,6 +88,200 @@ static void ssd_send_event_up_path (ioreq_event *curr, double delay)
    }
 }
 
+/*
+ * latency records: every request carries the times at which it arrives,
+ * gets the channel back to the controller, queues its pages on the
+ * elements and completes. they feed the latency histograms and, if it
+ * is enabled, the latency breakdown.
+ */
+static ssd_lat *ssd_lat_get(ssd_t *s)
+{
+    ssd_lat *lat = s->lat_free;
+
+    if (lat != NULL) {
+        s->lat_free = lat->next;
+    } else if (!(lat = (ssd_lat *)malloc(sizeof(ssd_lat)))) {
+        fprintf(stderr, "Error: malloc to ssd_lat in ssd_lat_get failed\n");
+        fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_lat));
+        exit(1);
+    }
+
+    memset(lat, 0, sizeof(ssd_lat));
+    return lat;
+}
+
+static ssd_lat_page *ssd_lat_page_get(ssd_t *s)
+{
+    ssd_lat_page *page = s->lat_page_free;
+
+    if (page != NULL) {
+        s->lat_page_free = page->next;
+    } else if (!(page = (ssd_lat_page *)malloc(sizeof(ssd_lat_page)))) {
+        fprintf(stderr, "Error: malloc to ssd_lat_page in ssd_lat_page_get failed\n");
+        fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_lat_page));
+        exit(1);
+    }
+
+    return page;
+}
+
+/*
+ * the element cleans for 'cost' from now, or from the end of the
+ * cleaning it is already doing.
+ */
+static void ssd_lat_clean(ssd_t *s, ssd_element *elem, double cost)
+{
+    if (elem->clean_end < simtime) {
+        elem->clean_end = simtime;
+    }
+    elem->clean_end += cost;
+    elem->clean_time += cost;
+
+    ssd_hist_add(&s->stat.lat.gc, cost);
+    ssd_hist_add(&elem->lat->gc, cost);
+}
+
+// the time the element has spent cleaning up to now
+static double ssd_lat_cleaned(ssd_element *elem)
+{
+    double cleaned = elem->clean_time;
+
+    if (elem->clean_end > simtime) {
+        cleaned -= elem->clean_end - simtime;
+    }
+    return cleaned;
+}
+
+static void ssd_lat_arrive(ssd_t *s, ioreq_event *curr)
+{
+    ssd_lat *lat = ssd_lat_get(s);
+
+    lat->arrive = simtime;
+    curr->ssd_lat = lat;
+}
+
+// the request gets the channel back to the controller
+static void ssd_lat_start(ssd_t *s, ioreq_event *curr)
+{
+    ((ssd_lat *)curr->ssd_lat)->start = simtime;
+}
+
+// the pages of the request are about to be queued on the elements
+static void ssd_lat_media(ssd_t *s, ioreq_event *curr)
+{
+    ssd_lat *lat = (ssd_lat *)curr->ssd_lat;
+
+    lat->media = simtime;
+    lat->page_end = simtime;
+}
+
+// a page of a request is queued on an element that is activated at 'activate'
+static void ssd_lat_queue_page(ssd_t *s, ssd_element *elem, ioreq_event *page_req, double activate)
+{
+    ssd_lat_page *page = ssd_lat_page_get(s);
+
+    page->queued = simtime;
+    page->activate = activate;
+    page->cleaned = ssd_lat_cleaned(elem);
+    page_req->ssd_lat = page;
+}
+
+/*
+ * the element issues the page, which is over at 'end'. for the breakdown,
+ * the waiting time of the page is split into the channel delay, the
+ * cleaning of the element and the rest of the time in the element queue.
+ * a cleaning that the element does before serving the page is a gc stall
+ * as well.
+ */
+static void ssd_lat_issue_page(ssd_t *s, ssd_element *elem, ioreq_event *page_req, double end)
+{
+    ssd_lat_page *page = (ssd_lat_page *)page_req->ssd_lat;
+    ssd_lat *lat;
+    double wait, channel, gc, pending;
+
+    ssd_hist_add(&s->stat.lat.queue_wait, simtime - page->queued);
+    ssd_hist_add(&elem->lat->queue_wait, simtime - page->queued);
+    if (page_req->flags & READ) {
+        ssd_hist_add(&elem->lat->read, end - page->queued);
+    } else {
+        ssd_hist_add(&elem->lat->write, end - page->queued);
+    }
+
+    // the pages read ahead by the buffer cache are not broken down
+    lat = (ssd_lat *)((ioreq_event *)page_req->tempptr2)->ssd_lat;
+    if ((s->params.latency_breakdown) && (lat != NULL)) {
+
+        wait = simtime - lat->media;
+        channel = ((page->activate < simtime) ? page->activate : simtime) - lat->media;
+        if (channel < 0) {
+            channel = 0;
+        }
+        gc = ssd_lat_cleaned(elem) - page->cleaned;
+        if (gc > wait - channel) {
+            gc = wait - channel;
+        }
+        pending = elem->clean_end - simtime;
+        if (pending < 0) {
+            pending = 0;
+        } else if (pending > end - simtime) {
+            pending = end - simtime;
+        }
+
+        lat->pages ++;
+        if (end >= lat->page_end) {
+            lat->page_end = end;
+            lat->phase[SSD_LAT_CHANNEL] = channel;
+            lat->phase[SSD_LAT_GC] = gc + pending;
+            lat->phase[SSD_LAT_ELEMENT] = wait - channel - gc;
+            lat->phase[SSD_LAT_ARRAY] = end - simtime - pending;
+        }
+    }
+
+    page->next = s->lat_page_free;
+    s->lat_page_free = page;
+    page_req->ssd_lat = NULL;
+}
+
+// the last page of the request completes
+static void ssd_lat_done(ssd_t *s, ioreq_event *curr)
+{
+    ssd_lat *lat = (ssd_lat *)curr->ssd_lat;
+
+    lat->done = simtime;
+
+    // the pages served by the gangs are not broken down
+    if (lat->pages == 0) {
+        lat->phase[SSD_LAT_ARRAY] = simtime - lat->media;
+    }
+}
+
+// the completion of the request is sent up the line
+static void ssd_lat_complete(ssd_t *s, ioreq_event *curr)
+{
+    ssd_lat *lat = (ssd_lat *)curr->ssd_lat;
+    int rw = (curr->flags & READ) ? SSD_LAT_READ : SSD_LAT_WRITE;
+    int i;
+
+    if (rw == SSD_LAT_READ) {
+        ssd_hist_add(&s->stat.lat.read, simtime - lat->arrive);
+    } else {
+        ssd_hist_add(&s->stat.lat.write, simtime - lat->arrive);
+    }
+
+    if (s->params.latency_breakdown) {
+        lat->phase[SSD_LAT_QUEUE] = lat->start - lat->arrive;
+        lat->phase[SSD_LAT_XFER] = (lat->media - lat->start) + (simtime - lat->done);
+
+        for (i = 0; i < SSD_LAT_PHASES; i ++) {
+            ssd_hist_add(&s->stat.lat_phase[rw][i], lat->phase[i]);
+        }
+    }
+
+    lat->next = s->lat_free;
+    s->lat_free = lat;
+    curr->ssd_lat = NULL;
+}
+
 /* The idea here is that only one request can "possess" the channel back to the
    controller at a time. All others are enqueued on queue of pending activities.
    "Completions" ... those operations that need only be signaled as done to the
@@ -96,13 +293,46 @@ static void ssd_send_event_up_path (ioreq_event *curr, double delay)
    code (and that in ssd_request_arrive) will handle this case "properly" by enqueuing
    the incoming request.  */
 
+/* the completion queue is a fifo with a tail pointer, so that
+   appending a finished parent request does not walk the queue. */
+
+static void ssd_completion_enqueue (ssd_t *currdisk, ioreq_event *curr)
+{
+   curr->next = NULL;
+   if (currdisk->completion_tail == NULL) {
+      currdisk->completion_queue = curr;
+   } else {
+      currdisk->completion_tail->next = curr;
+   }
+   currdisk->completion_tail = curr;
+
+   currdisk->completion_qlen ++;
+   if (currdisk->stat.max_completion_qlen < currdisk->completion_qlen) {
+      currdisk->stat.max_completion_qlen = currdisk->completion_qlen;
+   }
+}
+
+static ioreq_event *ssd_completion_dequeue (ssd_t *currdisk)
+{
+   ioreq_event *curr = currdisk->completion_queue;
+
+   if (curr != NULL) {
+      currdisk->completion_queue = curr->next;
+      if (currdisk->completion_queue == NULL) {
+         currdisk->completion_tail = NULL;
+      }
+      currdisk->completion_qlen --;
+   }
+
+   return curr;
+}
+
 static void ssd_check_channel_activity (ssd_t *currdisk)
 {
    while (1) {
-       ioreq_event *curr = currdisk->completion_queue;
+       ioreq_event *curr = ssd_completion_dequeue(currdisk);
        currdisk->channel_activity = curr;
        if (curr != NULL) {
-           currdisk->completion_queue = curr->next;
 
            if (curr->flags & READ) {
                /* transfer data up the line: curr->bcount, which is still set to */
@@ -117,6 +347,7 @@ static void ssd_check_channel_activity (ssd_t *currdisk)
            curr = ioqueue_get_next_request(currdisk->queue);
            currdisk->channel_activity = curr;
            if (curr != NULL) {
+               ssd_lat_start(currdisk, curr);
                if (curr->flags & READ) {
                    ssd_media_access_request(curr);
                    continue;
@@ -145,6 +376,7 @@ static void ssd_request_complete(ioreq_event *curr)
 
    currdisk = getssd (curr->devno);
    ssd_assert_current_activity(currdisk, curr);
+   ssd_lat_complete(currdisk, curr);
 
    if ((x = ioqueue_physical_access_done(currdisk->queue,curr)) == NULL) {
       fprintf(stderr, "ssd_request_complete:  ioreq_event not found by ioqueue_physical_access_done call\n");
@@ -192,9 +424,158 @@ int ssd_already_present(ssd_req **reqs, int total, ioreq_event *req)
     return found;
 }
 
+/*
+ * duplicate request detection for ssd_activate_elem.
+ */
+void ssd_dedup_init(ssd_t *s)
+{
+    if (!(s->dedup.slots = (ssd_dedup_slot *)malloc(sizeof(ssd_dedup_slot) * SSD_DEDUP_SET_SIZE))) {
+        fprintf(stderr, "Error: malloc to dedup set in ssd_dedup_init failed\n");
+        fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_dedup_slot) * SSD_DEDUP_SET_SIZE);
+        exit(1);
+    }
+    memset(s->dedup.slots, 0, sizeof(ssd_dedup_slot) * SSD_DEDUP_SET_SIZE);
+    s->dedup.gen = 0;
+}
+
+static void ssd_dedup_reset(ssd_dedup_set *set)
+{
+    set->gen ++;
+
+    // on a wrap around, the stale slots could look valid again
+    if (set->gen == 0) {
+        memset(set->slots, 0, sizeof(ssd_dedup_slot) * SSD_DEDUP_SET_SIZE);
+        set->gen = 1;
+    }
+}
+
+/*
+ * adds the request to the set. returns 1 if a request with the same
+ * blkno and flags was already there.
+ */
+static int ssd_dedup_insert(ssd_dedup_set *set, ioreq_event *req)
+{
+    unsigned int i;
+
+    i = ((unsigned int)req->blkno * 2654435761u) ^ (unsigned int)req->flags;
+    while (1) {
+        ssd_dedup_slot *slot;
+
+        i &= (SSD_DEDUP_SET_SIZE - 1);
+        slot = &set->slots[i];
+
+        if (slot->gen != set->gen) {
+            slot->blkno = req->blkno;
+            slot->flags = req->flags;
+            slot->gen = set->gen;
+            return 0;
+        }
+
+        if ((slot->blkno == req->blkno) && (slot->flags == req->flags)) {
+            return 1;
+        }
+
+        i ++;
+    }
+}
+
+/*
+ * request pool: every ssd gets a slab of ssd_req objects and the request
+ * vectors of its elements and gangs when it is initialized. activating an
+ * element or a gang then just takes objects off the free list and puts
+ * them back. only if the slab runs dry do we fall back to the heap.
+ */
+void ssd_req_pool_init(ssd_t *s)
+{
+    int i;
+    int j;
+    ssd_req_pool *p = &s->req_pool;
+
+    p->size = SSD_REQ_POOL_SIZE(s);
+    if (!(p->slab = (ssd_req *)malloc(sizeof(ssd_req) * p->size)) ||
+        !(p->free_list = (ssd_req **)malloc(sizeof(ssd_req *) * p->size))) {
+        fprintf(stderr, "Error: malloc to req_pool in ssd_req_pool_init failed\n");
+        fprintf(stderr, "Allocation size = %d\n", (sizeof(ssd_req) + sizeof(ssd_req *)) * p->size);
+        exit(1);
+    }
+
+    for (i = 0; i < p->size; i ++) {
+        p->free_list[i] = &p->slab[p->size - 1 - i];
+    }
+    p->num_free = p->size;
+
+    for (i = 0; i < s->params.nelements; i ++) {
+        ssd_element *elem = &s->elements[i];
+
+        if (!(elem->read_reqs = (ssd_req **)malloc(sizeof(ssd_req *) * MAX_REQS_ELEM_QUEUE)) ||
+            !(elem->write_reqs = (ssd_req **)malloc(sizeof(ssd_req *) * MAX_REQS_ELEM_QUEUE))) {
+            fprintf(stderr, "Error: malloc to elem reqs in ssd_req_pool_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_req *) * MAX_REQS_ELEM_QUEUE);
+            exit(1);
+        }
+    }
+
+    for (i = 0; i < SSD_NUM_GANG(s); i ++) {
+        gang_metadata *g = &s->gang_meta[i];
+
+        if (!(g->rd_q = (ssd_req ***)malloc(sizeof(ssd_req **) * s->params.elements_per_gang)) ||
+            !(g->wr_q = (ssd_req ***)malloc(sizeof(ssd_req **) * s->params.elements_per_gang))) {
+            fprintf(stderr, "Error: malloc to gang queues in ssd_req_pool_init failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_req **) * s->params.elements_per_gang);
+            exit(1);
+        }
+
+        for (j = 0; j < s->params.elements_per_gang; j ++) {
+            if (!(g->rd_q[j] = (ssd_req **)malloc(sizeof(ssd_req *) * MAX_REQS)) ||
+                !(g->wr_q[j] = (ssd_req **)malloc(sizeof(ssd_req *) * MAX_REQS))) {
+                fprintf(stderr, "Error: malloc to gang queues in ssd_req_pool_init failed\n");
+                fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_req *) * MAX_REQS);
+                exit(1);
+            }
+        }
+    }
+}
+
+ssd_req *ssd_req_get(ssd_t *s)
+{
+    ssd_req_pool *p = &s->req_pool;
+    ssd_req *r;
+
+    if (p->num_free > 0) {
+        p->num_free --;
+        r = p->free_list[p->num_free];
+        s->stat.reqs_pooled ++;
+    } else {
+        if (!(r = (ssd_req *)malloc(sizeof(ssd_req)))) {
+            fprintf(stderr, "Error: malloc to ssd_req in ssd_req_get failed\n");
+            fprintf(stderr, "Allocation size = %d\n", sizeof(ssd_req));
+            exit(1);
+        }
+        s->stat.req_allocs ++;
+    }
+
+    return r;
+}
+
+void ssd_req_put(ssd_t *s, ssd_req *r)
+{
+    ssd_req_pool *p = &s->req_pool;
+
+    if ((r >= p->slab) && (r < p->slab + p->size)) {
+        ASSERT(p->num_free < p->size);
+        p->free_list[p->num_free] = r;
+        p->num_free ++;
+    } else {
+        free(r);
+    }
+}
+
 double _ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
 {
+    double prof = ssd_prof_begin(s);
     double clean_cost = ssd_clean_element(s, elem_num);
+
+    ssd_prof_end(s, SSD_PROF_CLEAN, prof);
     return clean_cost;
 }
 
@@ -215,7 +596,7 @@ static int ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
     if (max_cost > 0) {
         ioreq_event *tmp;
 
-        elem->media_busy = 1;
+        ssd_set_media_busy(s, elem, TRUE);
         cleaning_invoked = 1;
 
         // we use the 'blkno' field to store the element number
@@ -233,7 +614,9 @@ static int ssd_invoke_element_cleaning(int elem_num, ssd_t *s)
 
         // stat
         elem->stat.tot_clean_time += max_cost;
-		elem->power_stat.acc_time += max_cost;
+        ssd_lat_clean(s, elem, max_cost);
+        ssd_chrome_trace_span(s, SSD_CHROME_GC, elem_num, "clean", simtime, simtime + max_cost, -1);
+		ssd_power_add_acc_time(max_cost, &elem->power_stat, s);
 		ssd_dpower(s, max_cost);
     }
 
@@ -311,10 +694,11 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
         // in order to simplify the overlapping strategy, let's issue
         // requests of the same type together.
 
-        read_reqs = (ssd_req **) malloc(max_reqs * sizeof(ssd_req *));
-        write_reqs = (ssd_req **) malloc(max_reqs * sizeof(ssd_req *));
+        read_reqs = elem->read_reqs;
+        write_reqs = elem->write_reqs;
 
         // collect the requests
+        ssd_dedup_reset(&currdisk->dedup);
         while ((req = ioqueue_get_next_request(elem->queue)) != NULL) {
             int found = 0;
 
@@ -323,15 +707,11 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
             // see if we already have the same request in the list.
             // this usually doesn't happen -- but on synthetic traces
             // this weird case can occur.
-            if (req->flags & READ) {
-                found = ssd_already_present(read_reqs, read_total, req);
-            } else {
-                found = ssd_already_present(write_reqs, write_total, req);
-            }
+            found = ssd_dedup_insert(&currdisk->dedup, req);
 
             if (!found) {
                 // this is a valid request
-                ssd_req *r = malloc(sizeof(ssd_req));
+                ssd_req *r = ssd_req_get(currdisk);
                 r->blk = req->blkno;
                 r->count = req->bcount;
                 r->is_read = req->flags & READ;
@@ -356,6 +736,7 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
                 // throw this request -- it doesn't make sense
                 stat_update (&currdisk->stat.acctimestats, 0);
                 req->time = simtime;
+                ssd_lat_issue_page(currdisk, elem, req, simtime);
                 req->ssd_elem_num = elem_num;
                 req->type = DEVICE_ACCESS_COMPLETE;
                 addtointq ((event *)req);
@@ -370,7 +751,7 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 
             // add an event for each request completion
             for (i = 0; i < read_total; i ++) {
-              elem->media_busy = TRUE;
+              ssd_set_media_busy(currdisk, elem, TRUE);
 
               // find the maximum time taken by a request
               if (schtime < read_reqs[i]->schtime) {
@@ -379,6 +760,8 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
 
               stat_update (&currdisk->stat.acctimestats, read_reqs[i]->acctime);
               read_reqs[i]->org_req->time = simtime + read_reqs[i]->schtime;
+              ssd_lat_issue_page(currdisk, elem, read_reqs[i]->org_req, read_reqs[i]->org_req->time);
+              ssd_chrome_trace_span(currdisk, SSD_CHROME_ELEM, elem_num, "read", read_reqs[i]->org_req->time - read_reqs[i]->acctime, read_reqs[i]->org_req->time, read_reqs[i]->blk);
               read_reqs[i]->org_req->ssd_elem_num = elem_num;
               read_reqs[i]->org_req->type = DEVICE_ACCESS_COMPLETE;
 
@@ -386,12 +769,10 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
                 //  elem_num, read_reqs[i]->acctime, read_reqs[i]->org_req->time);
 
               addtointq ((event *)read_reqs[i]->org_req);
-              free(read_reqs[i]);
+              ssd_req_put(currdisk, read_reqs[i]);
             }
         }
 
-        free(read_reqs);
-
         max_time_taken = schtime;
 
 		//schtime == readtime
@@ -403,10 +784,12 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
             // note that we can issue the writes only after all the reads above are
             // over. so, include the maximum read time when creating the event.
             for (i = 0; i < write_total; i ++) {
-              elem->media_busy = TRUE;
+              ssd_set_media_busy(currdisk, elem, TRUE);
 
               stat_update (&currdisk->stat.acctimestats, write_reqs[i]->acctime);
               write_reqs[i]->org_req->time = simtime + schtime + write_reqs[i]->schtime;
+              ssd_lat_issue_page(currdisk, elem, write_reqs[i]->org_req, write_reqs[i]->org_req->time);
+              ssd_chrome_trace_span(currdisk, SSD_CHROME_ELEM, elem_num, "program", write_reqs[i]->org_req->time - write_reqs[i]->acctime, write_reqs[i]->org_req->time, write_reqs[i]->blk);
               //printf("blk %d elem %d acc time %f\n", write_reqs[i]->blk, elem_num, write_reqs[i]->acctime);
 
               if (max_time_taken < (schtime+write_reqs[i]->schtime)) {
@@ -419,12 +802,10 @@ static void ssd_activate_elem(ssd_t *currdisk, int elem_num)
                 //  elem_num, write_reqs[i]->acctime, write_reqs[i]->org_req->time);
 
               addtointq ((event *)write_reqs[i]->org_req);
-              free(write_reqs[i]);
+              ssd_req_put(currdisk, write_reqs[i]);
             }
         }
 
-        free(write_reqs);
-
         // statistics
         tot_reqs_issued = read_total + write_total;
         ASSERT(tot_reqs_issued > 0);
@@ -448,12 +829,41 @@ void ssd_activate(ioreq_event *curr)
 	elem_num = curr->ssd_elem_num;
 
 	// release this event
+	currdisk->elements[elem_num].activate = NULL;
 	addtoextraq((event *) curr);
 
 	ssd_activate_elem(currdisk, elem_num);
 }
 
 
+/*
+ * schedules the activation of an element at 'time'. an element has at
+ * most one SSD_ACTIVATE_ELEM event pending: a later activation folds
+ * into the pending one, which issues every request queued by then, and
+ * an earlier one moves the pending event forward.
+ */
+static void ssd_schedule_activate(ssd_t *currdisk, int elem_num, double time)
+{
+	ssd_element *elem = &currdisk->elements[elem_num];
+	ioreq_event *temp = elem->activate;
+
+	if (temp != NULL) {
+		if (temp->time <= time) {
+			currdisk->stat.activates_folded ++;
+			return;
+		}
+		removefromintq((event *)temp);
+	} else {
+		temp = (ioreq_event *)getfromextraq();
+		temp->type = SSD_ACTIVATE_ELEM;
+		temp->devno = currdisk->devno;
+		temp->ssd_elem_num = elem_num;
+		elem->activate = temp;
+	}
+	temp->time = time;
+	addtointq((event *)temp);
+}
+
 static void ssd_media_access_request_element (ioreq_event *curr)
 {
    ssd_t *currdisk = getssd(curr->devno);
@@ -499,58 +909,219 @@ static void ssd_media_access_request_element (ioreq_event *curr)
 	   {
 		   int ch_num;
 		   double wtime, ctime;
-		   ioreq_event *temp = (ioreq_event *)getfromextraq();
-		   temp->type = SSD_ACTIVATE_ELEM;
+		   double atime = simtime;
 		   //Insert Channel/Way delay
 		   //Channel Number = Chip number % Number of Channel
 		   ch_num = elem_num % currdisk->params.nchannel;
 		   wtime = currdisk->CH[ch_num].arrival_time + ssd_data_transfer_cost(currdisk,currdisk->params.page_size);
 		   ctime = simtime + (i * currdisk->params.channel_switch_delay);
 		   if(currdisk->params.nchannel == currdisk->params.nelements){
-			   temp->time = ctime;
+			   atime = ctime;
 			   currdisk->CH[ch_num].ccount++;
 		   }else if(simtime > wtime || currdisk->CH[ch_num].flag == -1){
 			   //channel data setting
 			   currdisk->CH[ch_num].arrival_time = ctime;
 			   currdisk->CH[ch_num].flag = curr->flags;
-			   temp->time = ctime;
+			   atime = ctime;
 			   currdisk->CH[ch_num].ccount++;
 		   }else if(currdisk->CH[ch_num].flag ==READ){
 			   if(wtime > ctime){
 				   if(curr->flags == READ){
-					   temp->time = wtime;
+					   atime = wtime;
 				   }else{
-					   temp->time = wtime + currdisk->params.page_read_latency;
+					   atime = wtime + currdisk->params.page_read_latency;
 				   }
 				   currdisk->CH[ch_num].wcount++;
 			   }else{
-				   temp->time = ctime;
+				   atime = ctime;
 				   currdisk->CH[ch_num].ccount++;
 			   }
-			   currdisk->CH[ch_num].arrival_time = temp->time;
+			   currdisk->CH[ch_num].arrival_time = atime;
 			   currdisk->CH[ch_num].flag = curr->flags;
 		   }else if(currdisk->CH[ch_num].flag == WRITE){
 			   if(wtime > ctime){
-					   temp->time = wtime;
+					   atime = wtime;
 					   currdisk->CH[ch_num].wcount++;
 			   }else{
-				   temp->time = ctime;
+				   atime = ctime;
 				   currdisk->CH[ch_num].ccount++;
 			   }
-			   currdisk->CH[ch_num].arrival_time = temp->time;
+			   currdisk->CH[ch_num].arrival_time = atime;
 			   currdisk->CH[ch_num].flag = curr->flags;
 		   }
-		   temp->ssd_elem_num = elem_num;
-		   addtointq ((event *)temp);
+		   ssd_lat_queue_page(currdisk, elem, tmp, atime);
+		   ssd_chrome_trace_span(currdisk, SSD_CHROME_CHANNEL, ch_num, (curr->flags & READ) ? "read xfer" : "write xfer",
+			   atime, atime + ssd_data_transfer_cost(currdisk, currdisk->params.page_size), tmp->blkno);
+		   ssd_schedule_activate(currdisk, elem_num, atime);
 		   i ++;
 	   }
    }
 }
 
+/*
+ * sends the sectors [blkno, blkno + bcount) of a request to the elements
+ * as a request of its own, which the request waits for. the reads ahead
+ * have no request to wait for them.
+ */
+static void ssd_buffer_cache_child(ssd_t *currdisk, ioreq_event *parent, int flags, int blkno, int bcount)
+{
+    ioreq_event *child = (ioreq_event *)getfromextraq();
+
+    child->type = SSD_BUFFER_CACHE_REQ;
+    child->devno = currdisk->devno;
+    child->busno = (parent != NULL) ? parent->busno : 0;
+    child->flags = flags;
+    child->blkno = blkno;
+    child->bcount = bcount;
+    child->tempptr2 = parent;
+    child->ssd_lat = (parent != NULL) ? parent->ssd_lat : NULL;
+
+    ssd_media_access_request_element(child);
+}
+
+// keeps the pages read by a request of the buffer cache in the buffer
+static void ssd_buffer_cache_fill(ssd_t *currdisk, ioreq_event *child)
+{
+    int page_size = currdisk->params.page_size;
+    int end = child->blkno + child->bcount;
+    int filled = 0;
+    int lpn;
+
+    for (lpn = child->blkno / page_size; lpn * page_size < end; lpn ++) {
+        filled += ssd_cache_fill(currdisk, lpn, (child->tempptr2 == NULL));
+    }
+
+    // the pages are written to the dram as they come from the elements
+    if (filled > 0) {
+        ssd_cache_access(currdisk, filled * page_size);
+    }
+}
+
+/*
+ * reads ahead of a sequential stream of reads. only the elements that
+ * are idle read pages ahead, so that the prefetches do not hold up the
+ * requests.
+ */
+static void ssd_buffer_cache_prefetch(ssd_t *currdisk, int first, int last)
+{
+    int page_size = currdisk->params.page_size;
+    int start = 0;
+    int n, lpn;
+
+    n = ssd_cache_readahead(currdisk, first, last, &start);
+    for (lpn = start; lpn < start + n; lpn ++) {
+        int blkno = lpn * page_size;
+        ssd_element *elem;
+
+        if (blkno + page_size > currdisk->numblocks) {
+            break;
+        }
+        elem = &currdisk->elements[ssd_choose_element(currdisk->user_params, blkno)];
+        if ((elem->media_busy) || (elem->metadata.reqs_waiting > 0) || ssd_cache_holds(currdisk, lpn)) {
+            continue;
+        }
+
+        currdisk->stat.cache_prefetches ++;
+        ssd_buffer_cache_child(currdisk, NULL, READ, blkno, page_size);
+    }
+}
+
+// the dram serves 'bcount' sectors of a request
+static void ssd_buffer_cache_dram(ssd_t *currdisk, ioreq_event *parent, int bcount)
+{
+    ioreq_event *tmp = (ioreq_event *)getfromextraq();
+
+    tmp->type = DEVICE_ACCESS_COMPLETE;
+    tmp->devno = parent->devno;
+    tmp->flags = parent->flags;
+    tmp->blkno = parent->blkno;
+    tmp->bcount = bcount;
+    tmp->ssd_elem_num = SSD_BUFFER_CACHE_ELEM;
+    tmp->tempptr2 = parent;
+    tmp->time = ssd_cache_access(currdisk, bcount);
+    addtointq((event *)tmp);
+}
+
+/*
+ * passes a request through the buffer cache. a write goes to the dram
+ * and, when it evicts dirty pages, waits for them to be written to the
+ * elements as well. the pages of a read found in the buffer are served
+ * by the dram and the others by the elements. returns 0 if the request
+ * has to go to the elements as it is.
+ */
+static int ssd_buffer_cache_access(ssd_t *currdisk, ioreq_event *curr)
+{
+    int page_size = currdisk->params.page_size;
+    int end = curr->blkno + curr->bcount;
+    int lpn = curr->blkno / page_size;
+    int blkno = curr->blkno;
+    int miss = -1;
+    int cached = 0;
+    int *destage;
+    int n, i, j;
+
+    /* **** CAREFUL ... HIJACKING tempint2 and tempptr2 fields here **** */
+    curr->tempint2 = curr->bcount;
+
+    if (curr->flags & READ) {
+        for (; blkno < end; lpn ++) {
+            int next = (lpn + 1) * page_size;
+
+            if (next > end) {
+                next = end;
+            }
+            if (ssd_cache_read(currdisk, lpn)) {
+                cached += next - blkno;
+                if (miss >= 0) {
+                    ssd_buffer_cache_child(currdisk, curr, curr->flags, miss, blkno - miss);
+                    miss = -1;
+                }
+            } else if (miss < 0) {
+                miss = blkno;
+            }
+            blkno = next;
+        }
+        // without the read cache, the reads that miss go on as they are
+        if ((cached == 0) && (!currdisk->params.read_cache)) {
+            return 0;
+        }
+        if (miss >= 0) {
+            ssd_buffer_cache_child(currdisk, curr, curr->flags, miss, end - miss);
+        }
+        if (cached > 0) {
+            ssd_buffer_cache_dram(currdisk, curr, cached);
+        }
+        if ((currdisk->params.read_cache) && (currdisk->params.read_ahead > 0)) {
+            ssd_buffer_cache_prefetch(currdisk, curr->blkno / page_size, (end - 1) / page_size);
+        }
+        return 1;
+    }
+
+    for (; lpn * page_size < end; lpn ++) {
+        n = ssd_cache_write(currdisk, lpn, &destage);
+
+        // the destaged pages go out in runs of consecutive pages
+        for (i = 0; i < n; i = j) {
+            for (j = i + 1; (j < n) && (destage[j] == destage[j - 1] + 1); j ++);
+
+            curr->tempint2 += (j - i) * page_size;
+            ssd_buffer_cache_child(currdisk, curr, WRITE, destage[i] * page_size, (j - i) * page_size);
+        }
+    }
+    ssd_buffer_cache_dram(currdisk, curr, curr->bcount);
+    return 1;
+}
+
 static void ssd_media_access_request (ioreq_event *curr)
 {
     ssd_t *currdisk = getssd(curr->devno);
 
+    ssd_lat_media(currdisk, curr);
+
+    if ((currdisk->cache != NULL) && ssd_buffer_cache_access(currdisk, curr)) {
+        return;
+    }
+
     switch(currdisk->params.alloc_pool_logic) {
         case SSD_ALLOC_POOL_PLANE:
         case SSD_ALLOC_POOL_CHIP:
@@ -613,12 +1184,14 @@ static void ssd_request_arrive (ioreq_event *curr)
    }
 
    /* create a new request, set it up for initial interrupt */
+   ssd_lat_arrive(currdisk, curr);
    ioqueue_add_new_request(currdisk->queue, curr);
    if (currdisk->channel_activity == NULL) {
 
       curr = ioqueue_get_next_request(currdisk->queue);
       currdisk->busowned = ssd_get_busno(curr);
       currdisk->channel_activity = curr;
+      ssd_lat_start(currdisk, curr);
       currdisk->reconnect_reason = IO_INTERRUPT_ARRIVE;
 
       if (curr->flags & READ) {
@@ -648,7 +1221,7 @@ static void ssd_clean_element_complete(ioreq_event *curr)
    addtoextraq((event *) curr);
 
    // activate the gang to serve the next set of requests
-   currdisk->elements[elem_num].media_busy = 0;
+   ssd_set_media_busy(currdisk, &currdisk->elements[elem_num], FALSE);
    ssd_activate_elem(currdisk, elem_num);
 }
 
@@ -661,45 +1234,63 @@ void ssd_complete_parent(ioreq_event *curr, ssd_t *currdisk)
     parent->tempint2 -= curr->bcount;
 
     if (parent->tempint2 == 0) {
-      ioreq_event *prev;
+      // a request of the buffer cache is over, on to the one it serves
+      if (parent->type == SSD_BUFFER_CACHE_REQ) {
+         if ((parent->flags & READ) && (currdisk->params.read_cache)) {
+            ssd_buffer_cache_fill(currdisk, parent);
+         }
+         if (parent->tempptr2 != NULL) {
+            ssd_complete_parent(parent, currdisk);
+         }
+         addtoextraq((event *) parent);
+         return;
+      }
 
       assert(parent != currdisk->channel_activity);
-      prev = currdisk->completion_queue;
-      if (prev == NULL) {
-         currdisk->completion_queue = parent;
-         parent->next = prev;
-      } else {
-         while (prev->next != NULL)
-            prev = prev->next;
-            parent->next = prev->next;
-            prev->next = parent;
-      }
+      ssd_lat_done(currdisk, parent);
+      ssd_completion_enqueue(currdisk, parent);
       if (currdisk->channel_activity == NULL) {
          ssd_check_channel_activity (currdisk);
       }
     }
 }
 
+/*
+ * returns 1 if the page at 'blkno' is picked by the page trace sampling.
+ * the pick only depends on the page, so all the records of a traced
+ * page are kept. the pages read are traced to outputfile5 and the
+ * written ones to outputfile4.
+ */
+static int ssd_page_traced(ssd_t *currdisk, int blkno)
+{
+   int n = currdisk->params.page_trace_sampling;
+   unsigned int h;
+
+   if (n <= 0) {
+      return 0;
+   }
+
+   // the block numbers of the pages are multiples of the page size,
+   // so they are hashed before one in every n of them is taken
+   h = (unsigned int)blkno * 2654435761u;
+   return (((h >> 16) % n) == 0);
+}
+
 static void ssd_access_complete_element(ioreq_event *curr)
 {
    ssd_t *currdisk;
    int elem_num;
    ssd_element  *elem;
    ioreq_event *x;
-   int lba;
 
    currdisk = getssd (curr->devno);
    elem_num = ssd_choose_element(currdisk->user_params, curr->blkno);
    ASSERT(elem_num == curr->ssd_elem_num);
    elem = &currdisk->elements[elem_num];
 
-   lba = ssd_logical_pageno(curr->blkno, currdisk);
-
-   if(curr->flags & READ){
-	   fprintf(outputfile5, "%10.6f %d %d %d\n", simtime, lba, elem_num, curr->blkno); 
-   }
-   else {
-	   fprintf(outputfile4, "%10.6f %d %d %d\n", simtime, lba, elem_num, curr->blkno); 
+   if (ssd_page_traced(currdisk, curr->blkno)) {
+      ssd_page_trace_append((curr->flags & READ) ? outputfile5 : outputfile4, simtime,
+         ssd_logical_pageno(curr->blkno, currdisk), elem_num, curr->blkno, 0);
    }
 
    if ((x = ioqueue_physical_access_done(elem->queue,curr)) == NULL) {
@@ -711,7 +1302,7 @@ static void ssd_access_complete_element(ioreq_event *curr)
 
    // all the reqs are over
    if (ioqueue_get_reqoutstanding(elem->queue) == 0) {
-		elem->media_busy = FALSE;
+		ssd_set_media_busy(currdisk, elem, FALSE);
    }
 
    ssd_complete_parent(curr, currdisk);
@@ -737,6 +1328,13 @@ static void ssd_access_complete(ioreq_event *curr)
 {
     ssd_t *currdisk = getssd (curr->devno);;
 
+    // the dram of the buffer cache is done
+    if ((currdisk->cache != NULL) && (curr->ssd_elem_num == SSD_BUFFER_CACHE_ELEM)) {
+        ssd_complete_parent(curr, currdisk);
+        addtoextraq((event *) curr);
+        return;
+    }
+
     switch(currdisk->params.alloc_pool_logic) {
         case SSD_ALLOC_POOL_PLANE:
         case SSD_ALLOC_POOL_CHIP:
@@ -818,39 +1416,49 @@ static void ssd_interrupt_complete (ioreq_event *curr)
 void ssd_process_event(ioreq_event *curr)
 {
    ssd_t *currdisk;
+   ssd_prof_entry_t entry;
+   double prof;
 
    currdisk = getssd (curr->devno);
+   prof = ssd_prof_begin(currdisk);
 
    switch (curr->type) {
 
 // disksim IO event
       case DEVICE_OVERHEAD_COMPLETE:
+         entry = SSD_PROF_REQUEST_ARRIVE;
          ssd_request_arrive(curr);
          break;
 
       case DEVICE_ACCESS_COMPLETE:
+         entry = SSD_PROF_ACCESS_COMPLETE;
          ssd_access_complete (curr);
          break;
 
       case DEVICE_DATA_TRANSFER_COMPLETE:
+         entry = SSD_PROF_TRANSFER_COMPLETE;
          ssd_bustransfer_complete(curr);
          break;
 
       case IO_INTERRUPT_COMPLETE:
+         entry = SSD_PROF_INTERRUPT_COMPLETE;
          ssd_interrupt_complete(curr);
          break;
 
 // SSD IO event
 		 //added by tiel
 	  case SSD_ACTIVATE_ELEM:
+          entry = SSD_PROF_ACTIVATE_ELEM;
           ssd_activate(curr);
           break;
 
       case SSD_CLEAN_GANG:
+          entry = SSD_PROF_CLEAN_GANG;
           ssd_clean_gang_complete(curr);
           break;
 
       case SSD_CLEAN_ELEMENT:
+          entry = SSD_PROF_CLEAN_ELEMENT;
           ssd_clean_element_complete(curr);
           break;
 
@@ -858,5 +1466,7 @@ void ssd_process_event(ioreq_event *curr)
          fprintf(stderr, "Unrecognized event type!\n");
          exit(1);
    }
+
+   ssd_prof_end(currdisk, entry, prof);
 }
 
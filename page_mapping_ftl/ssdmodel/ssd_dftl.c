@@ -0,0 +1,389 @@
+
+#include "ssd.h"
+#include "ssd_dftl.h"
+#include "ssd_power.h"
+
+static void *ssd_dftl_alloc(int size, char *name)
+{
+	void *p;
+
+	if ((p = malloc(size)) == NULL) {
+		fprintf(stderr, "Error: malloc to %s in ssd_dftl_init failed\n", name);
+		fprintf(stderr, "Allocation size = %d\n", size);
+		exit(1);
+	}
+	return p;
+}
+
+static void ssd_dftl_elem_init(ssd_t *s, ssd_dftl_elem *d, int num_entries, int entries_per_tpage)
+{
+	int ppb = s->params.pages_per_block;
+	int data_tblocks;
+	int spare;
+	int i;
+
+	d->num_entries = num_entries;
+	d->num_tpages = (s->data_pages_per_elem + entries_per_tpage - 1) / entries_per_tpage;
+
+	// the translation blocks are over-provisioned like the data blocks,
+	// and at least one of them is kept erased for the cleaning.
+	data_tblocks = (d->num_tpages + ppb - 1) / ppb;
+	spare = (data_tblocks * s->params.reserve_blocks) / 100;
+	if (spare < 2) {
+		spare = 2;
+	}
+	d->num_tblocks = data_tblocks + spare;
+
+	d->entries = (ssd_dftl_entry *)ssd_dftl_alloc(num_entries * sizeof(ssd_dftl_entry), "d->entries");
+	d->hash = (ssd_dftl_entry **)ssd_dftl_alloc(num_entries * sizeof(ssd_dftl_entry *), "d->hash");
+	d->dirty = (int *)ssd_dftl_alloc(d->num_tpages * sizeof(int), "d->dirty");
+	d->gtd = (int *)ssd_dftl_alloc(d->num_tpages * sizeof(int), "d->gtd");
+	d->owner = (int *)ssd_dftl_alloc(d->num_tblocks * ppb * sizeof(int), "d->owner");
+	d->valid = (int *)ssd_dftl_alloc(d->num_tblocks * sizeof(int), "d->valid");
+	d->free_blocks = (int *)ssd_dftl_alloc(d->num_tblocks * sizeof(int), "d->free_blocks");
+
+	// the cmt starts empty
+	d->free = NULL;
+	for (i = num_entries - 1; i >= 0; i --) {
+		d->entries[i].hnext = d->free;
+		d->free = &d->entries[i];
+	}
+	memset(d->hash, 0, num_entries * sizeof(ssd_dftl_entry *));
+	memset(d->dirty, 0, d->num_tpages * sizeof(int));
+	d->mru = d->lru = NULL;
+
+	// the translation pages are laid out in order from the first
+	// translation block, and the block of the last one is active.
+	memset(d->owner, -1, d->num_tblocks * ppb * sizeof(int));
+	memset(d->valid, 0, d->num_tblocks * sizeof(int));
+	for (i = 0; i < d->num_tpages; i ++) {
+		d->gtd[i] = i;
+		d->owner[i] = i;
+		d->valid[i / ppb] ++;
+	}
+	d->active_block = (d->num_tpages > 0) ? ((d->num_tpages - 1) / ppb) : 0;
+	d->active_page = d->num_tpages - d->active_block * ppb;
+
+	d->num_free = 0;
+	for (i = d->num_tblocks - 1; i > d->active_block; i --) {
+		d->free_blocks[d->num_free ++] = i;
+		d->valid[i] = -1;
+	}
+
+	d->relocated = -1;
+	d->relocated_blk = -1;
+}
+
+void ssd_dftl_init(ssd_t *s)
+{
+	ssd_dftl *t = s->dftl;
+	int num_entries = s->params.mapping_cache_size / (SSD_DFTL_CMT_ENTRY_BYTES * s->params.nelements);
+	int i;
+
+	if ((s->params.mapping_cache_size <= 0) || (t != NULL)) {
+		return;
+	}
+
+	// the gangs look their pages up in the whole mapping table
+	if (s->params.alloc_pool_logic == SSD_ALLOC_POOL_GANG) {
+		fprintf(stderr, "Warning: the mapping cache is not used with the gang allocation pool\n");
+		return;
+	}
+
+	if (num_entries < 1) {
+		fprintf(stderr, "Error: the mapping cache of %d bytes cannot hold an entry of each element\n",
+			s->params.mapping_cache_size);
+		exit(1);
+	}
+
+	t = (ssd_dftl *)ssd_dftl_alloc(sizeof(ssd_dftl), "dftl");
+	t->entries_per_tpage = SSD_DFTL_ENTRIES_PER_TPAGE(s);
+	for (i = 0; i < s->params.nelements; i ++) {
+		ssd_dftl_elem_init(s, &t->elems[i], num_entries, t->entries_per_tpage);
+	}
+
+	s->dftl = t;
+}
+
+static ssd_dftl_entry *ssd_dftl_lookup(ssd_dftl_elem *d, int lpn)
+{
+	ssd_dftl_entry *e;
+
+	for (e = d->hash[lpn % d->num_entries]; e != NULL; e = e->hnext) {
+		if (e->lpn == lpn) {
+			return e;
+		}
+	}
+	return NULL;
+}
+
+static void ssd_dftl_unlink(ssd_dftl_elem *d, ssd_dftl_entry *e)
+{
+	if (e->prev != NULL) {
+		e->prev->next = e->next;
+	} else {
+		d->mru = e->next;
+	}
+	if (e->next != NULL) {
+		e->next->prev = e->prev;
+	} else {
+		d->lru = e->prev;
+	}
+}
+
+static void ssd_dftl_push_mru(ssd_dftl_elem *d, ssd_dftl_entry *e)
+{
+	e->prev = NULL;
+	e->next = d->mru;
+	if (d->mru != NULL) {
+		d->mru->prev = e;
+	} else {
+		d->lru = e;
+	}
+	d->mru = e;
+}
+
+static void ssd_dftl_set_dirty(ssd_t *s, ssd_dftl_elem *d, ssd_dftl_entry *e)
+{
+	if (!e->dirty) {
+		e->dirty = 1;
+		d->dirty[e->lpn / s->dftl->entries_per_tpage] ++;
+	}
+}
+
+/*
+ * charges a flash operation on a translation page to the element. if
+ * 'at' is not NULL, the operation is placed on the power profile at *at,
+ * which is moved past it.
+ */
+static double ssd_dftl_op(ssd_t *s, int elem_num, ssd_power_type_t type, double time, double *at)
+{
+	ssd_power_element_stat *power_stat = &(s->elements[elem_num].power_stat);
+
+	ssd_power_flash_calculate(type, time, power_stat, s);
+	if (at != NULL) {
+		ssd_power_profile_op(s, elem_num, type, *at, time);
+		*at += time;
+	}
+	return time;
+}
+
+static double ssd_dftl_read_tpage(ssd_t *s, int elem_num, double *at)
+{
+	double cost = 0;
+
+	cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_READ, s->params.page_read_latency, at);
+	cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_BUS_DATA_TRANSFER, ssd_data_transfer_cost(s, s->params.page_size), at);
+	s->stat.dftl_tpage_reads ++;
+
+	return cost;
+}
+
+/*
+ * writes the translation page 't' to the next page of the active
+ * translation block. the cleaning keeps a block erased, so this never
+ * has to clean.
+ */
+static void ssd_dftl_program(ssd_t *s, ssd_dftl_elem *d, int t)
+{
+	int ppb = s->params.pages_per_block;
+	int ppage;
+
+	if (d->active_page == ppb) {
+		ASSERT(d->num_free > 0);
+		d->active_block = d->free_blocks[-- d->num_free];
+		d->active_page = 0;
+		d->valid[d->active_block] = 0;
+	}
+
+	ppage = d->active_block * ppb + d->active_page;
+	d->active_page ++;
+
+	if (d->gtd[t] != -1) {
+		d->owner[d->gtd[t]] = -1;
+		d->valid[d->gtd[t] / ppb] --;
+	}
+	d->gtd[t] = ppage;
+	d->owner[ppage] = t;
+	d->valid[d->active_block] ++;
+}
+
+/*
+ * cleans the translation block with the fewest valid pages. its valid
+ * pages are copied to the active block inside the element before it is
+ * erased.
+ */
+static double ssd_dftl_clean(ssd_t *s, int elem_num, ssd_dftl_elem *d, double *at)
+{
+	int ppb = s->params.pages_per_block;
+	int victim = -1;
+	double cost = 0;
+	int i;
+
+	// the erased blocks have no valid count
+	for (i = 0; i < d->num_tblocks; i ++) {
+		if ((i == d->active_block) || (d->valid[i] < 0) || (d->valid[i] == ppb)) {
+			continue;
+		}
+		if ((victim == -1) || (d->valid[i] < d->valid[victim])) {
+			victim = i;
+		}
+	}
+	ASSERT(victim != -1);
+
+	for (i = victim * ppb; i < (victim + 1) * ppb; i ++) {
+		if (d->owner[i] != -1) {
+			cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_READ, s->params.page_read_latency, at);
+			cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_WRITE, s->params.page_write_latency, at);
+			ssd_dftl_program(s, d, d->owner[i]);
+			s->stat.dftl_pages_moved ++;
+		}
+	}
+	ASSERT(d->valid[victim] == 0);
+
+	cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_ERASE, s->params.block_erase_latency, at);
+	d->free_blocks[d->num_free ++] = victim;
+	d->valid[victim] = -1;
+	s->stat.dftl_cleans ++;
+
+	return cost;
+}
+
+static double ssd_dftl_write_tpage(ssd_t *s, int elem_num, int t, double *at)
+{
+	ssd_dftl_elem *d = &s->dftl->elems[elem_num];
+	double cost = 0;
+
+	// the last erased block is only taken by the cleaning
+	while ((d->active_page == s->params.pages_per_block) && (d->num_free <= 1)) {
+		cost += ssd_dftl_clean(s, elem_num, d, at);
+	}
+
+	cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_BUS_DATA_TRANSFER, ssd_data_transfer_cost(s, s->params.page_size), at);
+	cost += ssd_dftl_op(s, elem_num, SSD_POWER_FLASH_WRITE, s->params.page_write_latency, at);
+	ssd_dftl_program(s, d, t);
+	s->stat.dftl_tpage_writes ++;
+
+	return cost;
+}
+
+/*
+ * brings the translation page 't' up to date in the flash: it is read,
+ * updated with the dirty entries of the cmt and written back.
+ */
+static double ssd_dftl_update_tpage(ssd_t *s, int elem_num, int t, double *at)
+{
+	ssd_dftl_elem *d = &s->dftl->elems[elem_num];
+	int per_tpage = s->dftl->entries_per_tpage;
+	ssd_dftl_entry *e;
+	double cost = 0;
+	int lpn;
+
+	cost += ssd_dftl_read_tpage(s, elem_num, at);
+	cost += ssd_dftl_write_tpage(s, elem_num, t, at);
+
+	for (lpn = t * per_tpage; (d->dirty[t] > 0) && (lpn < (t + 1) * per_tpage); lpn ++) {
+		if (((e = ssd_dftl_lookup(d, lpn)) != NULL) && (e->dirty)) {
+			e->dirty = 0;
+			d->dirty[t] --;
+		}
+	}
+	ASSERT(d->dirty[t] == 0);
+
+	return cost;
+}
+
+static double ssd_dftl_evict(ssd_t *s, int elem_num, ssd_dftl_elem *d, double *at)
+{
+	ssd_dftl_entry *e = d->lru;
+	ssd_dftl_entry **h = &d->hash[e->lpn % d->num_entries];
+	double cost = 0;
+
+	if (e->dirty) {
+		cost += ssd_dftl_update_tpage(s, elem_num, e->lpn / s->dftl->entries_per_tpage, at);
+	}
+
+	while (*h != e) {
+		h = &(*h)->hnext;
+	}
+	*h = e->hnext;
+
+	ssd_dftl_unlink(d, e);
+	e->hnext = d->free;
+	d->free = e;
+
+	return cost;
+}
+
+// charges the dram of the controller for a lookup in the cmt
+static void ssd_dftl_dram(ssd_t *s)
+{
+	ssd_power_ssd_calculate(SSD_POWER_DRAM_ACCESS, SSD_DFTL_CMT_ENTRY_BYTES * s->params.dram_active_latency, s);
+}
+
+/*
+ * looks up the mapping of the logical page 'lpn' of an element before
+ * it is read or written. returns the time spent on the translation
+ * pages, whose operations are placed on the power profile from 'offset'.
+ */
+double ssd_dftl_translate(ssd_t *s, int elem_num, int lpn, int is_write, double offset)
+{
+	ssd_dftl_elem *d = &s->dftl->elems[elem_num];
+	ssd_dftl_entry *e;
+	double cost = 0;
+
+	ssd_dftl_dram(s);
+
+	if ((e = ssd_dftl_lookup(d, lpn)) != NULL) {
+		s->stat.dftl_hits ++;
+		ssd_dftl_unlink(d, e);
+	} else {
+		s->stat.dftl_misses ++;
+		if (d->free == NULL) {
+			cost += ssd_dftl_evict(s, elem_num, d, &offset);
+		}
+		cost += ssd_dftl_read_tpage(s, elem_num, &offset);
+
+		e = d->free;
+		d->free = e->hnext;
+
+		e->lpn = lpn;
+		e->dirty = 0;
+		e->hnext = d->hash[lpn % d->num_entries];
+		d->hash[lpn % d->num_entries] = e;
+	}
+
+	if (is_write) {
+		ssd_dftl_set_dirty(s, d, e);
+	}
+	ssd_dftl_push_mru(d, e);
+
+	return cost;
+}
+
+/*
+ * updates the mapping of the logical page 'lpn' that the cleaning moved
+ * out of the block 'blk'. returns the time spent on its translation page.
+ */
+double ssd_dftl_relocate(ssd_t *s, int elem_num, int lpn, int blk)
+{
+	ssd_dftl_elem *d = &s->dftl->elems[elem_num];
+	ssd_dftl_entry *e;
+	int t = lpn / s->dftl->entries_per_tpage;
+
+	ssd_dftl_dram(s);
+
+	if ((e = ssd_dftl_lookup(d, lpn)) != NULL) {
+		ssd_dftl_set_dirty(s, d, e);
+		return 0;
+	}
+
+	// the pages of a block that share a translation page update it once
+	if ((t == d->relocated) && (blk == d->relocated_blk)) {
+		return 0;
+	}
+	d->relocated = t;
+	d->relocated_blk = blk;
+
+	return ssd_dftl_update_tpage(s, elem_num, t, NULL);
+}
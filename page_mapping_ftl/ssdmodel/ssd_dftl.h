@@ -0,0 +1,74 @@
+#ifndef DISKSIM_SSD_DFTL_H
+#define DISKSIM_SSD_DFTL_H
+
+#include "ssd.h"
+
+/*
+ * demand-paged mapping table (dftl). instead of the whole lba_table, the
+ * dram of the controller holds a cached mapping table (cmt) of "Mapping
+ * cache size" bytes, split evenly between the elements. the mapping of
+ * an element is kept in translation pages, each holding the physical
+ * page numbers of SSD_DFTL_ENTRIES_PER_TPAGE consecutive logical pages,
+ * which are written out of place to translation blocks of the element.
+ *
+ * a lookup that misses the cmt reads the translation page of the
+ * logical page. evicting a dirty entry reads its translation page,
+ * updates it and writes it back, which cleans all the dirty entries of
+ * that page in the cmt. the pages moved by the cleaning update the cmt
+ * if they are cached and their translation page otherwise, once for all
+ * the pages of a block that share it. when the translation blocks run
+ * out, the one with the fewest valid pages is cleaned.
+ *
+ * the translation blocks come on top of the blocks of the element, so
+ * the exported size is the same with or without the dftl. the
+ * lba_table still holds the whole mapping, the cmt only decides which
+ * lookups and updates cost flash operations.
+ */
+#define SSD_DFTL_ENTRY_BYTES		4		// physical page number in a translation page
+#define SSD_DFTL_CMT_ENTRY_BYTES	8		// logical and physical page numbers in the cmt
+#define SSD_DFTL_ENTRIES_PER_TPAGE(s)	((s)->params.page_size * SSD_DATA_BYTES_PER_SECTOR / SSD_DFTL_ENTRY_BYTES)
+
+typedef struct _ssd_dftl_entry {
+	int lpn;
+	int dirty;
+	struct _ssd_dftl_entry *prev;		// towards the mru end
+	struct _ssd_dftl_entry *next;		// towards the lru end
+	struct _ssd_dftl_entry *hnext;		// hash chain
+} ssd_dftl_entry;
+
+typedef struct _ssd_dftl_elem {
+	int num_entries;					// capacity of the cmt of the element
+	ssd_dftl_entry *entries;
+	ssd_dftl_entry *free;
+	ssd_dftl_entry *mru;
+	ssd_dftl_entry *lru;
+	ssd_dftl_entry **hash;
+	int *dirty;							// dirty cmt entries of each translation page
+
+	int num_tpages;						// translation pages of the element
+	int *gtd;							// global translation directory: the physical
+										// translation page holding each translation page
+	int num_tblocks;					// translation blocks of the element
+	int *owner;							// translation page in each physical translation
+										// page, -1 if it is free or invalid
+	int *valid;							// valid pages of each translation block, -1 if
+										// the block is erased
+	int *free_blocks;					// stack of the erased translation blocks
+	int num_free;
+	int active_block;					// translation block being written
+	int active_page;					// next page to write in it
+
+	int relocated;						// translation page updated for the last page
+	int relocated_blk;					// moved by the cleaning, and its block
+} ssd_dftl_elem;
+
+struct _ssd_dftl {
+	int entries_per_tpage;
+	ssd_dftl_elem elems[SSD_MAX_ELEMENTS];
+};
+
+void ssd_dftl_init(ssd_t *s);
+double ssd_dftl_translate(ssd_t *s, int elem_num, int lpn, int is_write, double offset);
+double ssd_dftl_relocate(ssd_t *s, int elem_num, int lpn, int blk);
+
+#endif
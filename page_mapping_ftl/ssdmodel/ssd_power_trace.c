@@ -0,0 +1,49 @@
+
+#include <string.h>
+
+#include "ssd_power_trace.h"
+
+// the power timeline shared by all the ssds
+static ssd_trace *power_trace = NULL;
+
+static void ssd_power_trace_append(FILE *fp, ssd_power_record *rec)
+{
+	if (power_trace == NULL) {
+		power_trace = ssd_trace_open(fp, SSD_POWER_TRACE_MAGIC, sizeof(ssd_power_record));
+	}
+	ssd_trace_append(power_trace, rec);
+}
+
+void ssd_power_trace_section(FILE *fp, double time, double current, double power, double cost, double energy)
+{
+	ssd_power_record rec;
+
+	rec.type = SSD_POWER_REC_SECTION;
+	rec.pad = 0;
+	rec.time = time;
+	rec.current = current;
+	rec.power = power;
+	rec.cost = cost;
+	rec.energy = energy;
+	ssd_power_trace_append(fp, &rec);
+}
+
+void ssd_power_trace_current(FILE *fp, double time, double current)
+{
+	ssd_power_record rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = SSD_POWER_REC_CURRENT;
+	rec.time = time;
+	rec.current = current;
+	ssd_power_trace_append(fp, &rec);
+}
+
+void ssd_power_trace_header(FILE *fp)
+{
+	ssd_power_record rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.type = SSD_POWER_REC_HEADER;
+	ssd_power_trace_append(fp, &rec);
+}
@@ -0,0 +1,34 @@
+#ifndef DISKSIM_SSD_POWER_TRACE_H
+#define DISKSIM_SSD_POWER_TRACE_H
+
+#include <stdio.h>
+#include "ssd_trace.h"
+
+/*
+ * the power timeline is written to outputfile2 as fixed size binary
+ * records instead of text. ssd_power_conv turns a timeline back into
+ * the "#SSD Power Distribution" csv.
+ */
+#define SSD_POWER_TRACE_MAGIC		"SSDPWR01"
+
+typedef enum {
+	SSD_POWER_REC_HEADER,		// start of the csv, no values
+	SSD_POWER_REC_SECTION,		// time, current, power, cost, energy
+	SSD_POWER_REC_CURRENT,		// time, current
+} ssd_power_rec_type_t;
+
+typedef struct _ssd_power_record {
+	int type;
+	int pad;
+	double time;
+	double current;
+	double power;
+	double cost;
+	double energy;
+} ssd_power_record;
+
+void ssd_power_trace_section(FILE *fp, double time, double current, double power, double cost, double energy);
+void ssd_power_trace_current(FILE *fp, double time, double current);
+void ssd_power_trace_header(FILE *fp);
+
+#endif
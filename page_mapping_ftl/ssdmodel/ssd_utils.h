@@ -9,10 +9,27 @@
 //                 code for bit manipulation routines
 //////////////////////////////////////////////////////////////////////////////
 
-void ssd_clear_bit(unsigned char *c, int pos);
-void ssd_set_bit(unsigned char *c, int pos);
-int ssd_bit_on(unsigned char *c, int pos);
-int ssd_find_zero_bit(unsigned char *c, int total, int start);
+// the bitmap is kept in 64-bit words. a summary level keeps one bit per
+// word, which is set when all the bits of that word are set, so that the
+// searches can skip over the full words.
+typedef unsigned long long ssd_bitmap_word;
+
+#define SSD_BITS_PER_WORD           64
+#define SSD_BITMAP_WORDS(bits)      (((bits) + SSD_BITS_PER_WORD - 1) / SSD_BITS_PER_WORD)
+
+typedef struct _ssd_bitmap {
+    int             total;          // num of bits in the bitmap
+    ssd_bitmap_word *words;         // the bits (pos 0 is the lsb of the first word)
+    ssd_bitmap_word *full;          // summary: one bit per word in 'words'
+} ssd_bitmap;
+
+ssd_bitmap *ssd_bitmap_alloc(int total);
+void ssd_clear_bit(ssd_bitmap *c, int pos);
+void ssd_set_bit(ssd_bitmap *c, int pos);
+int ssd_bit_on(ssd_bitmap *c, int pos);
+int ssd_find_zero_bit(ssd_bitmap *c, int total, int start);
+int ssd_find_zero_bit_in_range(ssd_bitmap *c, int first, int last, int start);
+int ssd_count_zero_bits(ssd_bitmap *c, int first, int last);
 
 
 //////////////////////////////////////////////////////////////////////////////